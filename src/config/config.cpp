@@ -1,3 +1,12 @@
 #include "config.h"
 
 const char *FIRMWARE_URL = "http://178.16.130.164:3025/firmware/latest";
+
+// Chaque device en choisit un par hachage de rendez-vous sur son UUID (voir ingest_endpoints.h)
+const char *HEARTBEAT_URLS[] = {
+    "http://192.168.0.18:3000/prout-o-metre/heartbeat",
+};
+const int HEARTBEAT_URL_COUNT = sizeof(HEARTBEAT_URLS) / sizeof(HEARTBEAT_URLS[0]);
+
+// À renseigner avec la CA qui signe les certificats ECDSA des serveurs avant de passer les URL en https://
+const char *TLS_ROOT_CA = "";
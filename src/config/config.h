@@ -1,3 +1,10 @@
 #pragma once
 
 extern const char *FIRMWARE_URL;
+
+// Endpoints d'ingestion par défaut ; le serveur peut en assigner d'autres ("ingest_endpoints")
+extern const char *HEARTBEAT_URLS[];
+extern const int HEARTBEAT_URL_COUNT;
+
+// Certificat racine (PEM, ECDSA) des serveurs HTTPS ; requis pour toute URL https://
+extern const char *TLS_ROOT_CA;
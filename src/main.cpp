@@ -9,27 +9,46 @@
 #include "modules/ota/ota_manager.h"
 #include "modules/sensors/sensors_manager.h"
 #include "modules/sensors/sensor_buffer.h"
+#include "modules/local_server/local_server_manager.h"
+#include "modules/acoustic/acoustic_manager.h"
+#include "modules/inference/inference_manager.h"
+#include "modules/log/log_manager.h"
+#include "modules/trace/trace_manager.h"
+#include "modules/tls/tls_client.h"
+#include "modules/burst/burst_capture.h"
 
 // ...existing code...
 
 void setup()
 {
   Serial.begin(115200);
+  logManagerInit();
   Serial.print("Firmware version: ");
   Serial.println(VERSION);
   sensorsManagerInit();
   sensorBufferInit();
+  acousticManagerInit();
+  burstCaptureInit();
+  inferenceManagerInit();
   screenManagerInit();
   wifiManagerInit();
+  localServerManagerInit();
+  tlsSessionCacheInit();
   heartbeatManagerInit();
   otaManagerInit();
 }
 
 void loop()
 {
+  unsigned long loopStart = micros();
   wifiManagerProcess();
   screenManagerProcess();
   sensorBufferProcess(); // Prend un échantillon toutes les 100ms si nécessaire
+  burstCaptureProcess();
   otaManagerHandle();
+  inferenceManagerProcess();
+  localServerManagerProcess();
+  traceManagerProcess();
+  localServerReportLoopTime(micros() - loopStart);
   delay(50);
 }
\ No newline at end of file
@@ -0,0 +1,196 @@
+#include "acoustic_dsp.h"
+#include <math.h>
+#include <string.h>
+
+#if ACOUSTIC_USE_ESP_DSP
+#include <esp_dsp.h>
+#endif
+
+const float ACOUSTIC_BAND_CENTERS[ACOUSTIC_BAND_COUNT] = {250.0f, 500.0f, 1000.0f, 2000.0f, 4000.0f};
+
+static const float ENERGY_EPSILON = 1e-12f;
+
+static float window[ACOUSTIC_FFT_SIZE];
+static float fftData[ACOUSTIC_FFT_SIZE * 2]; // complexes entrelacés (re, im)
+static int bandFirstBin[ACOUSTIC_BAND_COUNT];
+static int bandLastBin[ACOUSTIC_BAND_COUNT];
+
+#if !ACOUSTIC_USE_ESP_DSP
+static float twiddles[ACOUSTIC_FFT_SIZE]; // cos/sin entrelacés, N/2 valeurs complexes
+#endif
+
+// ======== FFT ========
+
+#if ACOUSTIC_USE_ESP_DSP
+
+static bool fftInit()
+{
+    return dsps_fft2r_init_fc32(NULL, ACOUSTIC_FFT_SIZE) == ESP_OK;
+}
+
+static void fftCompute(float *data)
+{
+    dsps_fft2r_fc32(data, ACOUSTIC_FFT_SIZE);
+    dsps_bit_rev_fc32(data, ACOUSTIC_FFT_SIZE);
+}
+
+#else
+
+static bool fftInit()
+{
+    for (int k = 0; k < ACOUSTIC_FFT_SIZE / 2; k++)
+    {
+        float angle = -2.0f * (float)M_PI * k / ACOUSTIC_FFT_SIZE;
+        twiddles[2 * k] = cosf(angle);
+        twiddles[2 * k + 1] = sinf(angle);
+    }
+    return true;
+}
+
+// FFT radix-2 itérative, en place, sur ACOUSTIC_FFT_SIZE complexes entrelacés
+static void fftCompute(float *data)
+{
+    const int n = ACOUSTIC_FFT_SIZE;
+
+    // Permutation par inversion de bits
+    for (int i = 1, j = 0; i < n; i++)
+    {
+        int bit = n >> 1;
+        for (; j & bit; bit >>= 1)
+            j ^= bit;
+        j |= bit;
+        if (i < j)
+        {
+            float re = data[2 * i], im = data[2 * i + 1];
+            data[2 * i] = data[2 * j];
+            data[2 * i + 1] = data[2 * j + 1];
+            data[2 * j] = re;
+            data[2 * j + 1] = im;
+        }
+    }
+
+    // Papillons
+    for (int len = 2; len <= n; len <<= 1)
+    {
+        int half = len >> 1;
+        int step = n / len;
+        for (int start = 0; start < n; start += len)
+        {
+            for (int k = 0; k < half; k++)
+            {
+                float wr = twiddles[2 * k * step];
+                float wi = twiddles[2 * k * step + 1];
+                int a = 2 * (start + k);
+                int b = 2 * (start + k + half);
+                float tr = data[b] * wr - data[b + 1] * wi;
+                float ti = data[b] * wi + data[b + 1] * wr;
+                data[b] = data[a] - tr;
+                data[b + 1] = data[a + 1] - ti;
+                data[a] += tr;
+                data[a + 1] += ti;
+            }
+        }
+    }
+}
+
+#endif
+
+// ======== INITIALISATION ========
+
+bool acousticDspInit()
+{
+    for (int i = 0; i < ACOUSTIC_FFT_SIZE; i++)
+        window[i] = 0.5f - 0.5f * cosf(2.0f * (float)M_PI * i / (ACOUSTIC_FFT_SIZE - 1));
+
+    // Bornes des bandes d'octave [fc/√2, fc·√2[, limitées à Nyquist
+    const float binWidth = (float)ACOUSTIC_SAMPLE_RATE / ACOUSTIC_FFT_SIZE;
+    for (int b = 0; b < ACOUSTIC_BAND_COUNT; b++)
+    {
+        int first = (int)ceilf(ACOUSTIC_BAND_CENTERS[b] / (float)M_SQRT2 / binWidth);
+        int last = (int)ceilf(ACOUSTIC_BAND_CENTERS[b] * (float)M_SQRT2 / binWidth) - 1;
+        bandFirstBin[b] = first < 1 ? 1 : first;
+        bandLastBin[b] = last > ACOUSTIC_FFT_SIZE / 2 ? ACOUSTIC_FFT_SIZE / 2 : last;
+    }
+
+    return fftInit();
+}
+
+// ======== CARACTÉRISTIQUES ========
+
+void acousticComputeFeatures(const uint16_t *samples, AcousticFeatures &features)
+{
+    const int n = ACOUSTIC_FFT_SIZE;
+    const float binWidth = (float)ACOUSTIC_SAMPLE_RATE / n;
+
+    // Retrait de la composante continue (le MAX4466 est centré sur VCC/2) puis fenêtrage
+    float mean = 0.0f;
+    for (int i = 0; i < n; i++)
+        mean += samples[i];
+    mean /= n;
+
+    for (int i = 0; i < n; i++)
+    {
+        fftData[2 * i] = (samples[i] - mean) * window[i];
+        fftData[2 * i + 1] = 0.0f;
+    }
+
+    fftCompute(fftData);
+
+    // Spectre de puissance sur la moitié utile (le signal est réel), DC exclu
+    float totalPower = 0.0f;
+    float weightedSum = 0.0f;
+    float logSum = 0.0f;
+    float bandPower[ACOUSTIC_BAND_COUNT] = {0};
+
+    for (int k = 1; k <= n / 2; k++)
+    {
+        float re = fftData[2 * k];
+        float im = fftData[2 * k + 1];
+        float power = re * re + im * im;
+
+        totalPower += power;
+        weightedSum += power * k * binWidth;
+        logSum += logf(power + ENERGY_EPSILON);
+
+        for (int b = 0; b < ACOUSTIC_BAND_COUNT; b++)
+        {
+            if (k >= bandFirstBin[b] && k <= bandLastBin[b])
+                bandPower[b] += power;
+        }
+    }
+
+    for (int b = 0; b < ACOUSTIC_BAND_COUNT; b++)
+        features.bandDb[b] = 10.0f * log10f(bandPower[b] + ENERGY_EPSILON);
+
+    const int binCount = n / 2;
+    features.centroidHz = totalPower > ENERGY_EPSILON ? weightedSum / totalPower : 0.0f;
+    features.flatness = totalPower > ENERGY_EPSILON
+                            ? expf(logSum / binCount) / (totalPower / binCount)
+                            : 0.0f;
+}
+
+// ======== AGRÉGATION ========
+
+void acousticFeaturesReset(AcousticFeatures &accumulator)
+{
+    memset(&accumulator, 0, sizeof(accumulator));
+}
+
+void acousticFeaturesAccumulate(AcousticFeatures &accumulator, const AcousticFeatures &block)
+{
+    for (int b = 0; b < ACOUSTIC_BAND_COUNT; b++)
+        accumulator.bandDb[b] += powf(10.0f, block.bandDb[b] / 10.0f);
+    accumulator.centroidHz += block.centroidHz;
+    accumulator.flatness += block.flatness;
+}
+
+void acousticFeaturesFinalize(AcousticFeatures &accumulator, int blockCount)
+{
+    if (blockCount <= 0)
+        return;
+
+    for (int b = 0; b < ACOUSTIC_BAND_COUNT; b++)
+        accumulator.bandDb[b] = 10.0f * log10f(accumulator.bandDb[b] / blockCount + ENERGY_EPSILON);
+    accumulator.centroidHz /= blockCount;
+    accumulator.flatness /= blockCount;
+}
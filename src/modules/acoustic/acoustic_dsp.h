@@ -0,0 +1,36 @@
+#pragma once
+#include <stdint.h>
+
+// ======== CONFIGURATION ========
+#define ACOUSTIC_SAMPLE_RATE 8000 // Fréquence d'échantillonnage du micro (Hz)
+#define ACOUSTIC_FFT_SIZE 128     // Taille d'un bloc (puissance de 2)
+#define ACOUSTIC_BAND_COUNT 5     // Bandes d'octave : 250, 500, 1k, 2k, 4k Hz
+
+// FFT optimisée esp-dsp sur la cible, implémentation portable sinon (build hôte)
+#if defined(ESP_PLATFORM) && __has_include(<esp_dsp.h>)
+#define ACOUSTIC_USE_ESP_DSP 1
+#else
+#define ACOUSTIC_USE_ESP_DSP 0
+#endif
+
+// ======== STRUCTURE ========
+struct AcousticFeatures
+{
+    float bandDb[ACOUSTIC_BAND_COUNT]; // énergie par bande d'octave (dB)
+    float centroidHz;                  // centroïde spectral (Hz)
+    float flatness;                    // planéité spectrale (0 = tonal, 1 = bruit blanc)
+};
+
+// Fréquences centrales des bandes d'octave (Hz)
+extern const float ACOUSTIC_BAND_CENTERS[ACOUSTIC_BAND_COUNT];
+
+// Préparer la fenêtre de Hann et les tables de la FFT
+bool acousticDspInit();
+
+// Calculer les caractéristiques d'un bloc de ACOUSTIC_FFT_SIZE échantillons ADC bruts
+void acousticComputeFeatures(const uint16_t *samples, AcousticFeatures &features);
+
+// Agrégation de plusieurs blocs (moyenne des énergies en linéaire)
+void acousticFeaturesReset(AcousticFeatures &accumulator);
+void acousticFeaturesAccumulate(AcousticFeatures &accumulator, const AcousticFeatures &block);
+void acousticFeaturesFinalize(AcousticFeatures &accumulator, int blockCount);
@@ -0,0 +1,176 @@
+#include "acoustic_manager.h"
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <esp_timer.h>
+#include "../../config/pins_config.h"
+
+static TaskHandle_t acousticTaskHandle = NULL;
+static hw_timer_t *sampleTimer = NULL;
+static portMUX_TYPE featuresMux = portMUX_INITIALIZER_UNLOCKED;
+static AcousticFeatures latestFeatures;
+static bool featuresAvailable = false;
+static volatile float cpuLoad = 0.0f;
+static volatile uint32_t lateSamples = 0;
+
+static uint16_t samples[ACOUSTIC_FFT_SIZE];
+static volatile uint32_t sampleTickCount = 0; // ticks du timer depuis le début du bloc
+static volatile int64_t firstTickUs = 0;       // date du premier tick du bloc
+
+// Tick du timer matériel : réveille la tâche pour un échantillon (analogRead n'est pas
+// utilisable en interruption, il prend le verrou de l'ADC1)
+static void IRAM_ATTR onSampleTimer()
+{
+    if (sampleTickCount++ == 0)
+        firstTickUs = esp_timer_get_time();
+    BaseType_t higherPriorityWoken = pdFALSE;
+    vTaskNotifyGiveFromISR(acousticTaskHandle, &higherPriorityWoken);
+    if (higherPriorityWoken)
+        portYIELD_FROM_ISR();
+}
+
+// Acquisition d'un bloc à ACOUSTIC_SAMPLE_RATE, cadencée par le timer : entre deux
+// échantillons la tâche est bloquée et le core 1 reste disponible.
+// Retourne le temps CPU consommé (µs, de l'échéance de l'échantillon ou de la lecture précédente
+// à la fin de la lecture), -1 si le timer ne répond pas.
+static int64_t acquireBlock()
+{
+    const int64_t periodUs = 1000000 / ACOUSTIC_SAMPLE_RATE;
+    int64_t busyUs = 0;
+    int64_t previousDone = 0;
+    ulTaskNotifyTake(pdTRUE, 0); // ticks résiduels d'un bloc précédent
+    sampleTickCount = 0;         // alarme coupée : pas de concurrence avec l'interruption
+    timerWrite(sampleTimer, 0);  // le compteur a continué pendant que l'alarme était coupée
+    timerAlarmEnable(sampleTimer);
+
+    for (int i = 0; i < ACOUSTIC_FFT_SIZE; i++)
+    {
+        // Un tick par échantillon : des ticks en retard sont rattrapés un par un
+        if (ulTaskNotifyTake(pdFALSE, pdMS_TO_TICKS(ACOUSTIC_SAMPLE_TIMEOUT_MS)) == 0)
+        {
+            timerAlarmDisable(sampleTimer);
+            return -1;
+        }
+        // Échéance de l'échantillon i : les ticks sont réguliers depuis le premier. Un
+        // rattrapage compare chaque échantillon à sa propre échéance, pas au dernier tick
+        int64_t due = firstTickUs + i * periodUs;
+        samples[i] = analogRead(MAX4466_PIN);
+        int64_t done = esp_timer_get_time();
+        if (done - due > periodUs)
+            lateSamples++;
+        busyUs += done - (previousDone > due ? previousDone : due);
+        previousDone = done;
+    }
+
+    timerAlarmDisable(sampleTimer);
+    return busyUs;
+}
+
+void acousticTask(void *parameter)
+{
+    TickType_t lastWake = xTaskGetTickCount();
+    TickType_t period = pdMS_TO_TICKS(ACOUSTIC_PERIOD_MS);
+
+    while (true)
+    {
+        vTaskDelayUntil(&lastWake, period);
+
+        // Budget : temps passé à lire l'ADC (réveils compris) et à calculer, pas l'attente des ticks
+        int64_t busyUs = 0;
+        bool acquired = true;
+
+        AcousticFeatures accumulator;
+        acousticFeaturesReset(accumulator);
+        for (int i = 0; i < ACOUSTIC_BLOCKS_PER_PERIOD && acquired; i++)
+        {
+            AcousticFeatures block;
+            int64_t acquisitionUs = acquireBlock();
+            acquired = acquisitionUs >= 0;
+            if (!acquired)
+                break;
+
+            int64_t dspStart = esp_timer_get_time();
+            acousticComputeFeatures(samples, block);
+            acousticFeaturesAccumulate(accumulator, block);
+            busyUs += acquisitionUs + (esp_timer_get_time() - dspStart);
+        }
+
+        if (acquired)
+        {
+            acousticFeaturesFinalize(accumulator, ACOUSTIC_BLOCKS_PER_PERIOD);
+            portENTER_CRITICAL(&featuresMux);
+            latestFeatures = accumulator;
+            featuresAvailable = true;
+            portEXIT_CRITICAL(&featuresMux);
+        }
+
+        // Respect du budget CPU : on allonge la période si l'étage coûte trop cher
+        cpuLoad = busyUs * 100.0f / (period * portTICK_PERIOD_MS * 1000.0f);
+        if (cpuLoad > ACOUSTIC_CPU_BUDGET_PERCENT)
+            period += pdMS_TO_TICKS(ACOUSTIC_PERIOD_MS);
+        else if (period > pdMS_TO_TICKS(ACOUSTIC_PERIOD_MS) && cpuLoad < ACOUSTIC_CPU_BUDGET_PERCENT / 2)
+            period -= pdMS_TO_TICKS(ACOUSTIC_PERIOD_MS);
+    }
+}
+
+void acousticManagerInit()
+{
+    Serial.println("Acoustic Manager: Initialisation de l'analyse spectrale...");
+
+    if (!acousticDspInit())
+    {
+        Serial.println("Acoustic Manager: Erreur - Impossible d'initialiser la FFT");
+        return;
+    }
+
+    // Timer matériel à 1 MHz, armé seulement pendant l'acquisition d'un bloc
+    sampleTimer = timerBegin(ACOUSTIC_TIMER_NUM, 80, true);
+    if (sampleTimer == NULL)
+    {
+        Serial.println("Acoustic Manager: Erreur - Impossible de créer le timer d'échantillonnage");
+        return;
+    }
+    timerAttachInterrupt(sampleTimer, &onSampleTimer, true);
+    timerAlarmWrite(sampleTimer, 1000000 / ACOUSTIC_SAMPLE_RATE, true);
+
+    // Même core que la loop principale, priorité 2 : la tâche dort entre deux ticks et
+    // ne préempte la loop que le temps d'une lecture, ce qui garde la cadence régulière
+    BaseType_t result = xTaskCreatePinnedToCore(
+        acousticTask,
+        "AcousticTask",
+        4096,
+        NULL,
+        2,
+        &acousticTaskHandle,
+        1);
+
+    if (result == pdPASS)
+    {
+        Serial.printf("Acoustic Manager: FFT %d points à %d Hz (%s)\n",
+                      ACOUSTIC_FFT_SIZE, ACOUSTIC_SAMPLE_RATE,
+                      ACOUSTIC_USE_ESP_DSP ? "esp-dsp" : "portable");
+    }
+    else
+    {
+        Serial.println("Acoustic Manager: Erreur - Impossible de créer la tâche acoustique");
+    }
+}
+
+bool acousticManagerGetFeatures(AcousticFeatures &features)
+{
+    portENTER_CRITICAL(&featuresMux);
+    bool available = featuresAvailable;
+    if (available)
+        features = latestFeatures;
+    portEXIT_CRITICAL(&featuresMux);
+    return available;
+}
+
+float acousticManagerGetCpuLoad()
+{
+    return cpuLoad;
+}
+
+uint32_t acousticManagerGetLateSampleCount()
+{
+    return lateSamples;
+}
@@ -0,0 +1,26 @@
+#pragma once
+#include <Arduino.h>
+#include "acoustic_dsp.h"
+
+// ======== CONFIGURATION ========
+#define ACOUSTIC_PERIOD_MS 100        // Période d'agrégation des caractéristiques (ms)
+#define ACOUSTIC_BLOCKS_PER_PERIOD 1  // Blocs FFT acquis par période
+#define ACOUSTIC_CPU_BUDGET_PERCENT 25 // Part max du core 1 consommée par l'étage acoustique
+#define ACOUSTIC_TIMER_NUM 0           // Timer matériel cadençant l'acquisition
+#define ACOUSTIC_SAMPLE_TIMEOUT_MS 5   // Tick manquant : bloc abandonné
+
+// Tâche d'analyse spectrale du MAX4466 (core 1).
+// Acquisition d'un bloc : ACOUSTIC_FFT_SIZE / ACOUSTIC_SAMPLE_RATE = 16 ms par période de 100 ms,
+// cadencée par un timer matériel ; la tâche dort entre deux échantillons.
+// Pas de DMA I2S : il réserverait l'ADC1 pendant tout le bloc, alors que les capteurs de gaz
+// (lectures à 10 Hz et capture rapide à 1 kHz) sont sur le même ADC.
+void acousticManagerInit();
+
+// Dernières caractéristiques agrégées (false si aucune encore disponible)
+bool acousticManagerGetFeatures(AcousticFeatures &features);
+
+// Charge CPU mesurée de l'étage acoustique sur le core 1 (%), acquisition comprise
+float acousticManagerGetCpuLoad();
+
+// Échantillons lus plus d'une période après leur échéance (premier tick du bloc + n périodes)
+uint32_t acousticManagerGetLateSampleCount();
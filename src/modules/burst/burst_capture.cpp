@@ -0,0 +1,105 @@
+#include "burst_capture.h"
+#include <esp_timer.h>
+#include <modules/sensors/sensor_buffer.h>
+#include <modules/log/log_manager.h>
+#include "../../config/pins_config.h"
+
+// ======== ÉTAT ========
+static BurstRecorder recorder;
+static BurstTiming timing; // écrit uniquement par le callback du timer
+static esp_timer_handle_t burstTimer = NULL;
+
+static volatile int pendingTrigger = -1; // déclenchement demandé hors du timer (micro)
+static uint32_t lastMicReading = 0;
+
+// ======== ACQUISITION ========
+
+// Callback esp_timer (tâche esp_timer, core 0) : trois lectures ADC par période,
+// le reste (détection, ring, emplacements) dans burst_recorder.cpp
+static void burstSampleCallback(void *arg)
+{
+    int64_t start = esp_timer_get_time();
+    BurstSample sample;
+    sample.mq135 = analogRead(MQ135_PIN);
+    sample.mq136 = analogRead(MQ136_PIN);
+    sample.mq4 = analogRead(MQ4_PIN);
+    burstTimingUpdate(timing, start, esp_timer_get_time());
+
+    int trigger = pendingTrigger;
+    pendingTrigger = -1;
+    burstRecorderAddSample(recorder, sample, millis(), trigger);
+}
+
+// ======== FONCTIONS PUBLIQUES ========
+
+void burstCaptureInit()
+{
+    Serial.println("Burst Capture: Initialisation de la capture rapide...");
+    burstRecorderInit(recorder);
+    burstTimingReset(timing);
+
+    esp_timer_create_args_t timerArgs = {};
+    timerArgs.callback = burstSampleCallback;
+    timerArgs.dispatch_method = ESP_TIMER_TASK;
+    timerArgs.name = "burst";
+
+    if (esp_timer_create(&timerArgs, &burstTimer) != ESP_OK ||
+        esp_timer_start_periodic(burstTimer, BURST_PERIOD_US) != ESP_OK)
+    {
+        Serial.println("Burst Capture: Erreur - Impossible de démarrer le timer");
+        return;
+    }
+
+    Serial.printf("Burst Capture: %d emplacements de %d ms (%d octets chacun)\n",
+                  BURST_CAPTURE_SLOTS, BURST_CAPTURE_SAMPLES * 1000 / BURST_SAMPLE_RATE, (int)sizeof(BurstCapture));
+}
+
+void burstCaptureProcess()
+{
+    // Le niveau sonore est évalué à chaque nouvelle lecture du buffer (100 ms)
+    SensorRecord reading;
+    uint32_t readingCount = getLastSensorReading(reading);
+    if (readingCount == lastMicReading)
+        return;
+    lastMicReading = readingCount;
+
+    if (reading.mic_db > BURST_MIC_TRIGGER_DB)
+        burstCaptureTrigger(BURST_TRIGGER_MIC);
+}
+
+void burstCaptureTrigger(BurstTrigger trigger)
+{
+    if (pendingTrigger < 0)
+        pendingTrigger = trigger;
+}
+
+const uint8_t *burstCaptureAcquire(size_t &size)
+{
+    return (const uint8_t *)burstRecorderAcquire(recorder, size);
+}
+
+void burstCaptureRelease(const uint8_t *capture, BurstUploadResult result)
+{
+    const BurstCapture *burst = (const BurstCapture *)capture;
+    uint32_t captureId = burst->header.captureId;
+    burstRecorderRelease(recorder, burst, result);
+
+    if (result == BURST_UPLOAD_OK)
+        LOG_INFO("Burst Capture: Capture %lu envoyée\n", (unsigned long)captureId);
+    else if (result == BURST_UPLOAD_REJECTED)
+        LOG_WARN("Burst Capture: Capture %lu refusée par le serveur, abandonnée\n", (unsigned long)captureId);
+}
+
+BurstCaptureStats burstCaptureGetStats()
+{
+    BurstCaptureStats stats;
+    stats.recorded = recorder.recorded;
+    stats.uploaded = recorder.uploaded;
+    stats.rejected = recorder.rejected;
+    stats.dropped = recorder.dropped;
+    stats.readAvgUs = timing.readAvgUs16 >> 4;
+    stats.readMaxUs = timing.readMaxUs;
+    stats.jitterMaxUs = timing.jitterMaxUs;
+    stats.lateSamples = timing.lateSamples;
+    return stats;
+}
@@ -0,0 +1,52 @@
+#pragma once
+#include <Arduino.h>
+#include "burst_recorder.h"
+
+// ======== CONFIGURATION ========
+#define BURST_MIC_TRIGGER_DB 75.0f    // Niveau sonore déclenchant une capture (dB)
+#define BURST_UPLOAD_SUFFIX "/capture"  // Envoi à <URL du heartbeat>/capture, après un heartbeat réussi
+
+// Toutes les BURST_SAMPLE_RATE⁻¹ s, un timer lit les trois capteurs de gaz dans un ring
+// permanent (l'historique pré-déclenchement). Sur une montée rapide d'un gaz ou un niveau
+// sonore élevé, ce ring est copié dans un emplacement libre, complété par les échantillons
+// suivants puis figé jusqu'à son envoi par la tâche heartbeat. Les emplacements sont alloués
+// statiquement : un déclenchement sans emplacement libre est compté et ignoré.
+//
+// Charge de l'ADC1, partagé sous verrou par analogRead :
+//   capture rapide    3 lectures à 1 kHz               3000 lectures/s  (tâche esp_timer, core 0)
+//   acoustique        128 lectures à 8 kHz / 100 ms    1280 lectures/s  (core 1, blocs de 16 ms)
+//   lectures à 10 Hz  4 lectures                         40 lectures/s  (loop, core 1)
+// soit ~4300 lectures/s, dont 70 % pour la capture rapide. Pendant un bloc acoustique, une
+// lecture toutes les 125 µs : les trois lectures de la capture s'y intercalent et retardent
+// l'échantillon acoustique suivant. Les deux effets sont mesurés sur /metrics :
+// proutometre_burst_read_us (durée des trois lectures, attente du verrou comprise),
+// proutometre_burst_jitter_max_us et proutometre_burst_late_samples_total (cadence de la
+// capture), proutometre_acoustic_late_samples_total (cadence acoustique).
+
+// ======== FONCTIONS PUBLIQUES ========
+void burstCaptureInit();
+
+// Déclenchement par le niveau sonore (loop principale)
+void burstCaptureProcess();
+
+// Demander une capture (sans effet si elle est déjà en cours ou pendant le délai de réarmement)
+void burstCaptureTrigger(BurstTrigger trigger);
+
+// Envoi : prendre la plus ancienne capture figée (NULL si aucune), puis la rendre.
+// BURST_UPLOAD_RETRY la remet en attente, BURST_UPLOAD_OK et BURST_UPLOAD_REJECTED libèrent l'emplacement.
+const uint8_t *burstCaptureAcquire(size_t &size);
+void burstCaptureRelease(const uint8_t *capture, BurstUploadResult result);
+
+struct BurstCaptureStats
+{
+    uint32_t recorded; // captures figées
+    uint32_t uploaded;
+    uint32_t rejected; // refusées par le serveur (4xx), abandonnées
+    uint32_t dropped;  // déclenchements sans emplacement libre
+    uint32_t readAvgUs;   // durée moyenne des trois lectures ADC d'un échantillon
+    uint32_t readMaxUs;
+    uint32_t jitterMaxUs; // écart max de la période d'échantillonnage
+    uint32_t lateSamples; // échantillons manqués (callback en retard de plus d'une période)
+};
+
+BurstCaptureStats burstCaptureGetStats();
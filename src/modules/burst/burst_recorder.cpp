@@ -0,0 +1,191 @@
+#include "burst_recorder.h"
+#include <string.h>
+
+// ======== DÉTECTEUR ========
+
+void burstDetectorReset(BurstDetector &detector)
+{
+    memset(&detector, 0, sizeof(detector));
+}
+
+int burstDetectorUpdate(BurstDetector &detector, const BurstSample &sample)
+{
+    const uint16_t values[BURST_CHANNEL_COUNT] = {sample.mq135, sample.mq136, sample.mq4};
+    int trigger = -1;
+    for (int c = 0; c < BURST_CHANNEL_COUNT; c++)
+    {
+        int32_t value = (int32_t)values[c] << 4;
+        if (!detector.ready)
+        {
+            detector.fastAverage[c] = value;
+            detector.slowAverage[c] = value;
+        }
+        detector.fastAverage[c] += (value - detector.fastAverage[c]) >> 3;
+        detector.slowAverage[c] += (value - detector.slowAverage[c]) >> 7;
+        if (detector.fastAverage[c] - detector.slowAverage[c] > (BURST_GAS_TRIGGER_ADC << 4))
+            trigger = c;
+    }
+    detector.ready = true;
+    return trigger;
+}
+
+// ======== ENREGISTREUR ========
+
+void burstRecorderInit(BurstRecorder &recorder)
+{
+    for (int i = 0; i < BURST_CAPTURE_SLOTS; i++)
+        recorder.slotStates[i].store(BURST_SLOT_FREE, std::memory_order_relaxed);
+    recorder.ringHead = 0;
+    recorder.ringFull = false;
+    recorder.recordingSlot = -1;
+    recorder.recordedCount = 0;
+    recorder.rearmAt = 0;
+    recorder.nextCaptureId = 1;
+    burstDetectorReset(recorder.detector);
+    recorder.recorded = 0;
+    recorder.dropped = 0;
+    recorder.uploaded = 0;
+    recorder.rejected = 0;
+}
+
+static void startCapture(BurstRecorder &recorder, BurstTrigger trigger, uint32_t now)
+{
+    recorder.rearmAt = now + BURST_REARM_MS;
+
+    // Un emplacement libre ne peut être repris que par le producteur : pas de concurrence ici
+    int slot = -1;
+    for (int i = 0; i < BURST_CAPTURE_SLOTS && slot < 0; i++)
+    {
+        if (recorder.slotStates[i].load(std::memory_order_acquire) == BURST_SLOT_FREE)
+            slot = i;
+    }
+    if (slot < 0)
+    {
+        recorder.dropped++;
+        return;
+    }
+    recorder.slotStates[slot].store(BURST_SLOT_RECORDING, std::memory_order_relaxed);
+
+    // Historique pré-déclenchement, du plus ancien au plus récent
+    BurstCapture &capture = recorder.captures[slot];
+    size_t olderCount = BURST_PRETRIGGER_SAMPLES - recorder.ringHead;
+    memcpy(capture.samples, recorder.ring + recorder.ringHead, olderCount * sizeof(BurstSample));
+    memcpy(capture.samples + olderCount, recorder.ring, recorder.ringHead * sizeof(BurstSample));
+
+    capture.header.magic = BURST_MAGIC;
+    capture.header.version = BURST_VERSION;
+    capture.header.trigger = trigger;
+    capture.header.channels = BURST_CHANNEL_COUNT;
+    capture.header.reserved = 0;
+    capture.header.sampleRate = BURST_SAMPLE_RATE;
+    capture.header.preTriggerSamples = BURST_PRETRIGGER_SAMPLES;
+    capture.header.sampleCount = 0;
+    capture.header.reserved2 = 0;
+    capture.header.triggerTime = now;
+    capture.header.captureId = recorder.nextCaptureId++;
+
+    recorder.recordingSlot = slot;
+    recorder.recordedCount = BURST_PRETRIGGER_SAMPLES;
+}
+
+bool burstRecorderAddSample(BurstRecorder &recorder, const BurstSample &sample, uint32_t now, int externalTrigger)
+{
+    recorder.ring[recorder.ringHead] = sample;
+    recorder.ringHead = (recorder.ringHead + 1) % BURST_PRETRIGGER_SAMPLES;
+    if (recorder.ringHead == 0)
+        recorder.ringFull = true;
+
+    // Capture en cours : on la complète, puis on la fige pour l'envoi
+    if (recorder.recordingSlot >= 0)
+    {
+        BurstCapture &capture = recorder.captures[recorder.recordingSlot];
+        capture.samples[recorder.recordedCount++] = sample;
+        if (recorder.recordedCount == BURST_CAPTURE_SAMPLES)
+        {
+            capture.header.sampleCount = recorder.recordedCount;
+            // Publication : la capture complète est visible avant l'état FROZEN
+            recorder.slotStates[recorder.recordingSlot].store(BURST_SLOT_FROZEN, std::memory_order_release);
+            recorder.recordingSlot = -1;
+            recorder.recorded++;
+        }
+    }
+
+    int trigger = burstDetectorUpdate(recorder.detector, sample);
+    if (trigger < 0)
+        trigger = externalTrigger;
+
+    // Historique complet requis, pas de déclenchement pendant une capture ni avant le réarmement
+    if (trigger < 0 || !recorder.ringFull || recorder.recordingSlot >= 0 || (int32_t)(now - recorder.rearmAt) < 0)
+        return false;
+    startCapture(recorder, (BurstTrigger)trigger, now);
+    return recorder.recordingSlot >= 0;
+}
+
+const BurstCapture *burstRecorderAcquire(BurstRecorder &recorder, size_t &size)
+{
+    // La plus ancienne d'abord
+    int slot = -1;
+    for (int i = 0; i < BURST_CAPTURE_SLOTS; i++)
+    {
+        if (recorder.slotStates[i].load(std::memory_order_acquire) == BURST_SLOT_FROZEN &&
+            (slot < 0 || recorder.captures[i].header.captureId < recorder.captures[slot].header.captureId))
+            slot = i;
+    }
+    if (slot < 0)
+        return NULL;
+
+    // Un emplacement figé n'est repris que par le consommateur
+    recorder.slotStates[slot].store(BURST_SLOT_UPLOADING, std::memory_order_relaxed);
+    const BurstCapture &capture = recorder.captures[slot];
+    size = sizeof(BurstCaptureHeader) + capture.header.sampleCount * sizeof(BurstSample);
+    return &capture;
+}
+
+void burstRecorderRelease(BurstRecorder &recorder, const BurstCapture *capture, BurstUploadResult result)
+{
+    int slot = capture - recorder.captures;
+    if (slot < 0 || slot >= BURST_CAPTURE_SLOTS ||
+        recorder.slotStates[slot].load(std::memory_order_relaxed) != BURST_SLOT_UPLOADING)
+        return;
+
+    if (result == BURST_UPLOAD_RETRY)
+    {
+        recorder.slotStates[slot].store(BURST_SLOT_FROZEN, std::memory_order_relaxed);
+        return;
+    }
+
+    if (result == BURST_UPLOAD_OK)
+        recorder.uploaded++;
+    else
+        recorder.rejected++;
+    // Remise au producteur : la lecture de la capture est terminée avant l'état FREE
+    recorder.slotStates[slot].store(BURST_SLOT_FREE, std::memory_order_release);
+}
+
+// ======== CADENCE ========
+
+void burstTimingReset(BurstTiming &timing)
+{
+    memset(&timing, 0, sizeof(timing));
+}
+
+void burstTimingUpdate(BurstTiming &timing, int64_t startUs, int64_t readDoneUs)
+{
+    if (timing.lastStartUs != 0)
+    {
+        int64_t interval = startUs - timing.lastStartUs;
+        uint32_t jitter = (uint32_t)(interval > BURST_PERIOD_US ? interval - BURST_PERIOD_US : BURST_PERIOD_US - interval);
+        if (jitter > timing.jitterMaxUs)
+            timing.jitterMaxUs = jitter;
+        if (interval > 2 * BURST_PERIOD_US)
+            timing.lateSamples++;
+    }
+    timing.lastStartUs = startUs;
+
+    uint32_t readUs = (uint32_t)(readDoneUs - startUs);
+    if (readUs > timing.readMaxUs)
+        timing.readMaxUs = readUs;
+    // Moyenne exponentielle en entiers, gardée à l'échelle 16 pour ne pas perdre l'arrondi
+    timing.readAvgUs16 = timing.samples == 0 ? readUs << 4 : timing.readAvgUs16 + readUs - (timing.readAvgUs16 >> 4);
+    timing.samples++;
+}
@@ -0,0 +1,148 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+
+// ======== CONFIGURATION ========
+// Nombre de captures conservées en attendant l'envoi (surcharge via build_flags)
+#ifndef BURST_CAPTURE_SLOTS
+#define BURST_CAPTURE_SLOTS 2
+#endif
+#define BURST_SAMPLE_RATE 1000        // Échantillonnage des capteurs de gaz (Hz)
+#define BURST_PRETRIGGER_SAMPLES 256  // Historique avant déclenchement (ms à 1 kHz)
+#define BURST_POSTTRIGGER_SAMPLES 1024 // Durée capturée après déclenchement (ms à 1 kHz)
+#define BURST_REARM_MS 5000           // Délai avant un nouveau déclenchement après une capture
+#define BURST_GAS_TRIGGER_ADC 40      // Écart moyenne rapide / moyenne lente déclenchant une capture (pas d'ADC)
+
+#define BURST_CAPTURE_SAMPLES (BURST_PRETRIGGER_SAMPLES + BURST_POSTTRIGGER_SAMPLES)
+#define BURST_CHANNEL_COUNT 3
+#define BURST_PERIOD_US (1000000 / BURST_SAMPLE_RATE)
+
+// Partie sans matériel de la capture rapide (testée sur l'hôte, voir test/test_burst_capture) :
+// détecteur de montée, ring pré-déclenchement et machine d'état des emplacements.
+// Un seul producteur (le callback du timer) et un seul consommateur (la tâche heartbeat) :
+// chaque état d'emplacement n'est modifié que par le côté qui le possède (FREE et RECORDING
+// par le producteur, FROZEN et UPLOADING par le consommateur), la remise de l'un à l'autre
+// passe par un atomique.
+
+// ======== FORMAT ========
+// Envoyé tel quel (octet par octet) en application/octet-stream, voir tools/burst_decoder.py
+#define BURST_MAGIC 0x50414342 // "BCAP" en little-endian
+#define BURST_VERSION 1
+
+enum BurstTrigger : uint8_t
+{
+    BURST_TRIGGER_MQ135 = 0,
+    BURST_TRIGGER_MQ136 = 1,
+    BURST_TRIGGER_MQ4 = 2,
+    BURST_TRIGGER_MIC = 3,
+};
+
+struct __attribute__((packed)) BurstSample
+{
+    uint16_t mq135; // valeurs ADC brutes
+    uint16_t mq136;
+    uint16_t mq4;
+};
+
+struct __attribute__((packed)) BurstCaptureHeader
+{
+    uint32_t magic;
+    uint8_t version;
+    uint8_t trigger;           // BurstTrigger
+    uint8_t channels;          // 3 : mq135, mq136, mq4
+    uint8_t reserved;
+    uint16_t sampleRate;       // Hz
+    uint16_t preTriggerSamples;
+    uint16_t sampleCount;
+    uint16_t reserved2;
+    uint32_t triggerTime;      // ms depuis le démarrage
+    uint32_t captureId;
+};
+
+// En-tête et échantillons contigus : une capture s'envoie d'un bloc, sans copie
+struct __attribute__((packed)) BurstCapture
+{
+    BurstCaptureHeader header;
+    BurstSample samples[BURST_CAPTURE_SAMPLES];
+};
+
+enum BurstSlotState : uint8_t
+{
+    BURST_SLOT_FREE = 0,
+    BURST_SLOT_RECORDING,
+    BURST_SLOT_FROZEN,
+    BURST_SLOT_UPLOADING,
+};
+
+// Issue d'un envoi
+enum BurstUploadResult : uint8_t
+{
+    BURST_UPLOAD_OK = 0,       // emplacement libéré
+    BURST_UPLOAD_RETRY,        // erreur de transport, 5xx, 429 : capture reproposée
+    BURST_UPLOAD_REJECTED,     // 4xx : la capture elle-même est refusée, emplacement libéré
+};
+
+// ======== DÉTECTEUR ========
+// Moyennes exponentielles rapide (~8 ms) et lente (~128 ms), en 1/16 de pas d'ADC ;
+// leur écart suit la pente du signal en filtrant le bruit
+struct BurstDetector
+{
+    int32_t fastAverage[BURST_CHANNEL_COUNT];
+    int32_t slowAverage[BURST_CHANNEL_COUNT];
+    bool ready;
+};
+
+void burstDetectorReset(BurstDetector &detector);
+
+// Canal (BurstTrigger) dont la montée dépasse BURST_GAS_TRIGGER_ADC, -1 sinon
+int burstDetectorUpdate(BurstDetector &detector, const BurstSample &sample);
+
+// ======== ENREGISTREUR ========
+struct BurstRecorder
+{
+    BurstCapture captures[BURST_CAPTURE_SLOTS];
+    std::atomic<uint8_t> slotStates[BURST_CAPTURE_SLOTS]; // BurstSlotState
+
+    // Producteur uniquement
+    BurstSample ring[BURST_PRETRIGGER_SAMPLES];
+    uint16_t ringHead; // prochain emplacement à écrire
+    bool ringFull;
+    int recordingSlot;
+    uint16_t recordedCount;
+    uint32_t rearmAt;
+    uint32_t nextCaptureId;
+    BurstDetector detector;
+
+    volatile uint32_t recorded; // captures figées (producteur)
+    volatile uint32_t dropped;  // déclenchements sans emplacement libre (producteur)
+    volatile uint32_t uploaded; // consommateur
+    volatile uint32_t rejected; // consommateur
+};
+
+void burstRecorderInit(BurstRecorder &recorder);
+
+// Producteur : un échantillon par période. externalTrigger : déclenchement demandé hors du
+// timer (micro), -1 si aucun. Retourne true si une capture vient de démarrer.
+bool burstRecorderAddSample(BurstRecorder &recorder, const BurstSample &sample, uint32_t now, int externalTrigger);
+
+// Consommateur : la plus ancienne capture figée (NULL si aucune), à rendre par burstRecorderRelease
+const BurstCapture *burstRecorderAcquire(BurstRecorder &recorder, size_t &size);
+void burstRecorderRelease(BurstRecorder &recorder, const BurstCapture *capture, BurstUploadResult result);
+
+// ======== CADENCE ========
+// Gigue du callback et durée des trois lectures ADC : l'ADC1 est partagé avec l'acquisition
+// acoustique (8 kHz par blocs de 16 ms) et les lectures à 10 Hz, une attente sur son verrou
+// allonge la lecture et décale les échantillons suivants.
+struct BurstTiming
+{
+    int64_t lastStartUs;   // début du callback précédent (0 : aucun)
+    uint32_t jitterMaxUs;  // écart max entre deux débuts et la période
+    uint32_t lateSamples;  // débuts séparés de plus de deux périodes (échantillon manqué)
+    uint32_t readMaxUs;    // durée max des trois lectures
+    uint32_t readAvgUs16;  // moyenne glissante (poids 1/16) de la durée des trois lectures, en 1/16 µs
+    uint32_t samples;
+};
+
+void burstTimingReset(BurstTiming &timing);
+void burstTimingUpdate(BurstTiming &timing, int64_t startUs, int64_t readDoneUs);
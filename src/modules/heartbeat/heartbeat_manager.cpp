@@ -2,25 +2,115 @@
 #include <modules/wifi/wifi_manager.h>
 #include <modules/sensors/sensors_manager.h>
 #include <modules/sensors/sensor_buffer.h>
-#include <version.h>
 #include <modules/uuid/uuid_manager.h>
 #include <modules/ota/ota_manager.h>
+#include <modules/inference/inference_manager.h>
+#include <modules/log/log_manager.h>
+#include <modules/trace/trace_manager.h>
+#include <modules/tls/tls_client.h>
+#include <modules/ingest/ingest_endpoints.h>
+#include "heartbeat_protocol.h"
+#include <modules/burst/burst_capture.h>
+#include <config/config.h>
 
 // Configuration du heartbeat
-static const char *HEARTBEAT_URL = "http://192.168.0.18:3000/prout-o-metre/heartbeat";
 static const unsigned long HEARTBEAT_INTERVAL = 5000; // Envoi toutes les 5 secondes
 static const unsigned long HTTP_TIMEOUT = 3000;       // Timeout de 3 secondes
 
 static TaskHandle_t heartbeatTaskHandle = NULL;
 volatile String otaUpdateUrl = "";
+static volatile uint32_t httpFailureCount = 0; // requêtes échouées (connexion ou code != 200)
+static volatile uint32_t failoverCount = 0;    // bascules sur échecs de l'endpoint d'ingestion
+
+// Extraire l'hôte, le port et le schéma d'une URL http(s)://hote[:port]/chemin
+static bool parseUrl(const char *url, String &host, uint16_t &port, bool &secure)
+{
+    const char *hostStart;
+    if (strncmp(url, "https://", 8) == 0)
+    {
+        secure = true;
+        hostStart = url + 8;
+    }
+    else if (strncmp(url, "http://", 7) == 0)
+    {
+        secure = false;
+        hostStart = url + 7;
+    }
+    else
+    {
+        return false;
+    }
+
+    const char *hostEnd = hostStart + strcspn(hostStart, ":/");
+    host = String(hostStart).substring(0, hostEnd - hostStart);
+    port = *hostEnd == ':' ? atoi(hostEnd + 1) : (secure ? 443 : 80);
+    return host.length() > 0 && port > 0;
+}
+
+// Envoyer la plus ancienne capture rapide figée, sur la connexion du heartbeat.
+// Priorité basse : au plus une par heartbeat réussi. Remise en attente seulement si l'échec
+// vient du transport ou du serveur (mêmes règles que le heartbeat) ; un 4xx vient de la
+// capture elle-même, la renvoyer n'y changerait rien : l'emplacement est libéré.
+static void uploadBurstCapture(HTTPClient &http, WiFiClient &client, IngestEndpointSet &endpoints, int endpointIndex,
+                               const char *url, const String &uuid)
+{
+    size_t size;
+    const uint8_t *capture = burstCaptureAcquire(size);
+    if (capture == NULL)
+        return;
+
+    TRACE_SCOPE("heartbeat.capture");
+
+    http.begin(client, String(url) + BURST_UPLOAD_SUFFIX);
+    http.setTimeout(HTTP_TIMEOUT);
+    http.addHeader("Content-Type", "application/octet-stream");
+    http.addHeader("User-Agent", "ProutOMetre-ESP32");
+    http.addHeader("X-Device-UUID", uuid);
+
+    int httpCode = http.POST((uint8_t *)capture, size);
+    http.end();
+
+    if (httpCode != 200)
+        httpFailureCount++;
+
+    // Un succès n'est pas rapporté : la durée d'un envoi de plusieurs ko fausserait la latence
+    if (httpCode <= 0 || httpCode >= 500 || httpCode == 429)
+    {
+        ingestReportFailure(endpoints, endpointIndex, httpCode == HTTPC_ERROR_READ_TIMEOUT, millis());
+        client.stop();
+        burstCaptureRelease(capture, BURST_UPLOAD_RETRY);
+        LOG_WARN("Heartbeat Task: Envoi de capture échoué (%d), nouvel essai au prochain heartbeat\n", httpCode);
+    }
+    else
+    {
+        burstCaptureRelease(capture, httpCode == 200 ? BURST_UPLOAD_OK : BURST_UPLOAD_REJECTED);
+    }
+}
 
 // Fonction de la tâche heartbeat (s'exécute en parallèle)
 void heartbeatTask(void *parameter)
 {
     HTTPClient http;
+    WiFiClient plainClient;
+    TlsClient tlsClient;
     bool isDebugEnabled = false;
     String deviceUUID = getUUID();
 
+    // Endpoints d'ingestion : liste de la config, remplacée par celle du serveur si fournie.
+    // La liste assignée par le serveur n'est pas persistée : il la renvoie au premier heartbeat.
+    static IngestEndpointSet endpoints;
+    ingestInit(endpoints, deviceUUID.c_str());
+    ingestSetEndpoints(endpoints, HEARTBEAT_URLS, HEARTBEAT_URL_COUNT);
+
+    char activeUrl[INGEST_URL_MAX] = "";
+    String host;
+    uint16_t port = 0;
+    bool secure = false;
+
+    // La connexion (et la session TLS) est gardée ouverte d'un heartbeat à l'autre
+    WiFiClient *client = &plainClient;
+    http.setReuse(true);
+
     while (true)
     {
         // Attendre l'intervalle du heartbeat
@@ -30,76 +120,138 @@ void heartbeatTask(void *parameter)
         if (!wifiManagerIsConnected())
             continue;
 
-        Serial.println("Heartbeat Task: Envoi du heartbeat...");
+        // Choisir l'endpoint ; en changer ferme la connexion gardée ouverte
+        uint32_t failoversBefore = endpoints.failovers;
+        int endpointIndex = ingestSelect(endpoints, millis());
+        failoverCount = endpoints.failovers;
+        if (endpointIndex < 0)
+            continue;
+        if (strcmp(activeUrl, endpoints.endpoints[endpointIndex].url) != 0)
+        {
+            if (endpoints.failovers != failoversBefore)
+                LOG_WARN("Heartbeat Task: Bascule vers %s\n", endpoints.endpoints[endpointIndex].url);
+            else
+                LOG_INFO("Heartbeat Task: Endpoint %s\n", endpoints.endpoints[endpointIndex].url);
+            client->stop();
+            strncpy(activeUrl, endpoints.endpoints[endpointIndex].url, sizeof(activeUrl));
+            if (!parseUrl(activeUrl, host, port, secure))
+            {
+                LOG_ERROR("Heartbeat Task: URL invalide %s\n", activeUrl);
+                ingestReportFailure(endpoints, endpointIndex, false, millis());
+                activeUrl[0] = '\0';
+                continue;
+            }
+            client = secure ? (WiFiClient *)&tlsClient : &plainClient;
+        }
+
+        LOG_DEBUG("Heartbeat Task: Envoi du heartbeat...");
+
+        String jsonPayload;
+        {
+            TRACE_SCOPE("heartbeat.serialize");
+
+            // Créer le document JSON pour le payload (UUID, version, échantillons si debug)
+            JsonDocument doc;
+            int records = heartbeatBuildPayload(doc, deviceUUID.c_str(), isDebugEnabled ? &getSensorBuffer() : NULL);
+            if (records > 0)
+                LOG_INFO("Heartbeat Task: Envoi de %d échantillons de capteurs\n", records);
+            else if (isDebugEnabled)
+                LOG_DEBUG("Heartbeat Task: Aucune donnée de capteur à envoyer");
+
+            // Ajouter la dernière classification embarquée
+            inferenceManagerAddToJson(doc);
 
-        // Créer le document JSON pour le payload
-        JsonDocument doc;
+            // Ajouter la trace si le serveur l'a demandée
+            traceManagerAddToJson(doc);
 
-        // Ajouter l'UUID et la version du firmware
-        doc["uuid"] = deviceUUID;
-        doc["firmwareVersion"] = VERSION;
+            // Sérialiser le JSON en string
+            serializeJson(doc, jsonPayload);
+        }
 
-        if (isDebugEnabled)
+        // Ouvrir la connexion TCP (réutilisée tant que le serveur la garde ouverte)
+        uint32_t requestStart = millis();
         {
-            // Vérifier s'il y a des données dans le buffer
-            int bufferSize = getSensorBufferSize();
-            if (bufferSize > 0)
-            {
-                Serial.printf("Heartbeat Task: Envoi de %d échantillons de capteurs\n", bufferSize);
-                // Ajouter toutes les données du buffer au JSON
-                getSensorBufferJson(doc);
-                // Vider le buffer après envoi
-                clearSensorBuffer();
-            }
-            else
+            TRACE_SCOPE("heartbeat.connect");
+            if (!client->connected() && !client->connect(host.c_str(), port, HTTP_TIMEOUT))
             {
-                Serial.println("Heartbeat Task: Aucune donnée de capteur à envoyer");
+                httpFailureCount++;
+                LOG_WARN("Heartbeat Task: Connexion à %s:%u impossible\n", host, port);
+                bool timeout = millis() - requestStart >= HTTP_TIMEOUT;
+                ingestReportFailure(endpoints, endpointIndex, timeout, millis());
+                continue;
             }
         }
 
-        // Sérialiser le JSON en string
-        String jsonPayload;
-        serializeJson(doc, jsonPayload);
+        int httpCode;
+        {
+            TRACE_SCOPE("heartbeat.post");
 
-        // Préparer et envoyer la requête HTTP
-        http.begin(HEARTBEAT_URL);
-        http.setTimeout(HTTP_TIMEOUT);
-        http.addHeader("Content-Type", "application/json");
-        http.addHeader("User-Agent", "ProutOMetre-ESP32");
+            // Préparer et envoyer la requête HTTP
+            http.begin(*client, activeUrl);
+            http.setTimeout(HTTP_TIMEOUT);
+            http.addHeader("Content-Type", "application/json");
+            http.addHeader("User-Agent", "ProutOMetre-ESP32");
+
+            httpCode = http.POST(jsonPayload); // Envoi de la requête POST avec le payload JSON
+        }
 
-        int httpCode = http.POST(jsonPayload); // Envoi de la requête POST avec le payload JSON
-        unsigned long requestTime = millis();
+        uint32_t latency = millis() - requestStart;
+
+        if (httpCode != 200)
+            httpFailureCount++;
+
+        // Santé de l'endpoint : seuls les erreurs de transport et les refus du serveur
+        // (5xx, 429) comptent comme des échecs, un 4xx vient de la requête elle-même
+        if (httpCode <= 0 || httpCode >= 500 || httpCode == 429)
+        {
+            ingestReportFailure(endpoints, endpointIndex, httpCode == HTTPC_ERROR_READ_TIMEOUT, millis());
+            client->stop();
+        }
+        else
+        {
+            ingestReportSuccess(endpoints, endpointIndex, latency, millis());
+        }
 
         if (httpCode <= 0)
         {
-            Serial.printf("Heartbeat Task: Connexion échouée: %s\n", http.errorToString(httpCode).c_str());
+            LOG_WARN("Heartbeat Task: Connexion échouée: %s\n", http.errorToString(httpCode));
         }
         else if (httpCode != 200)
         {
-            Serial.printf("Heartbeat Task: HTTP error %d\n", httpCode);
+            LOG_WARN("Heartbeat Task: HTTP error %d\n", httpCode);
         }
         else
         {
+            TRACE_SCOPE("heartbeat.parse");
+
             String response = http.getString();
-            Serial.printf("Heartbeat Task: Réponse HTTP 200: %s\n", response.c_str());
+            LOG_DEBUG("Heartbeat Task: Réponse HTTP 200: %s\n", response);
 
             JsonDocument doc;
-            if (deserializeJson(doc, response) == DeserializationError::Ok)
+            HeartbeatResponse commands;
+            if (heartbeatParseResponse(doc, response.c_str(), response.length(), commands))
             {
-                isDebugEnabled = doc["debug"].is<bool>() ? doc["debug"].as<bool>() : false;
-                if (doc["update_firmware_url"].is<const char *>())
-                {
-                    otaManagerSetUrl(
-                        doc["update_firmware_url"].as<const char *>());
-                }
+                isDebugEnabled = commands.debug;
+                if (commands.firmwareUrl)
+                    otaManagerSetUrl(commands.firmwareUrl);
+                if (commands.modelUrl)
+                    inferenceManagerSetModelUrl(commands.modelUrl);
+                if (commands.traceRequested)
+                    traceManagerRequestUpload();
+                if (commands.ingestEndpointCount > 0 &&
+                    ingestSetEndpoints(endpoints, commands.ingestEndpoints, commands.ingestEndpointCount))
+                    LOG_INFO("Heartbeat Task: %d endpoints d'ingestion assignés\n", commands.ingestEndpointCount);
             }
             else
             {
-                Serial.println("Heartbeat Task: Erreur parsing JSON");
+                LOG_ERROR("Heartbeat Task: Erreur parsing JSON");
             }
         }
 
         http.end();
+
+        if (httpCode == 200)
+            uploadBurstCapture(http, *client, endpoints, endpointIndex, activeUrl, deviceUUID);
     }
 }
 
@@ -111,7 +263,7 @@ void heartbeatManagerInit()
     BaseType_t result = xTaskCreatePinnedToCore(
         heartbeatTask,        // Fonction de la tâche
         "HeartbeatTask",      // Nom de la tâche
-        4096,                 // Taille de la pile (4KB)
+        8192,                 // Taille de la pile (8KB, le handshake TLS en a besoin)
         NULL,                 // Paramètre de la tâche
         1,                    // Priorité (1 = basse priorité)
         &heartbeatTaskHandle, // Handle de la tâche
@@ -129,3 +281,13 @@ void heartbeatManagerInit()
 
     Serial.println("Heartbeat Manager: Initialisation terminée");
 }
+
+uint32_t heartbeatGetHttpFailureCount()
+{
+    return httpFailureCount;
+}
+
+uint32_t heartbeatGetFailoverCount()
+{
+    return failoverCount;
+}
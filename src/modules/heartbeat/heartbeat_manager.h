@@ -20,5 +20,7 @@ struct HeartbeatData
 
 // Fonctions publiques du module heartbeat
 void heartbeatManagerInit();
+uint32_t heartbeatGetHttpFailureCount();
+uint32_t heartbeatGetFailoverCount();
 
 #endif // HEARTBEAT_MANAGER_H
\ No newline at end of file
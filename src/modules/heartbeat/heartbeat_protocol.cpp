@@ -0,0 +1,48 @@
+#include "heartbeat_protocol.h"
+#include <version.h>
+#include <modules/log/log_manager.h>
+
+int heartbeatBuildPayload(JsonDocument &doc, const char *uuid, SensorBuffer *buffer)
+{
+    // Ajouter l'UUID et la version du firmware
+    doc["uuid"] = uuid;
+    doc["firmwareVersion"] = VERSION;
+
+    if (buffer == NULL || buffer->getSize() == 0)
+        return 0;
+
+    // Ajouter toutes les données du buffer au JSON et le vider, d'un seul tenant : la boucle
+    // continue d'y stocker pendant ce temps sur l'autre cœur
+    return buffer->moveToJson(doc);
+}
+
+bool heartbeatParseResponse(JsonDocument &doc, const char *body, size_t length, HeartbeatResponse &response)
+{
+    memset(&response, 0, sizeof(response));
+    if (deserializeJson(doc, body, length) != DeserializationError::Ok)
+        return false;
+
+    response.debug = doc["debug"].is<bool>() ? doc["debug"].as<bool>() : false;
+    if (doc["update_firmware_url"].is<const char *>())
+        response.firmwareUrl = doc["update_firmware_url"].as<const char *>();
+    if (doc["update_model_url"].is<const char *>())
+        response.modelUrl = doc["update_model_url"].as<const char *>();
+    response.traceRequested = doc["trace"].is<bool>() && doc["trace"].as<bool>();
+
+    if (doc["ingest_endpoints"].is<JsonArrayConst>())
+    {
+        for (JsonVariantConst url : doc["ingest_endpoints"].as<JsonArrayConst>())
+        {
+            if (response.ingestEndpointCount >= INGEST_MAX_ENDPOINTS || !url.is<const char *>())
+                continue;
+            // Ne tiendrait pas dans IngestEndpoint::url : ignorée plutôt que tronquée
+            if (strlen(url.as<const char *>()) >= INGEST_URL_MAX)
+            {
+                LOG_WARN("Heartbeat: Endpoint d'ingestion ignoré, URL de plus de %d caractères\n", INGEST_URL_MAX - 1);
+                continue;
+            }
+            response.ingestEndpoints[response.ingestEndpointCount++] = url.as<const char *>();
+        }
+    }
+    return true;
+}
@@ -0,0 +1,25 @@
+#pragma once
+#include <ArduinoJson.h>
+#include <modules/sensors/sensor_buffer.h>
+#include <modules/ingest/ingest_endpoints.h>
+
+// Format des échanges avec le serveur d'ingestion, sans dépendance au transport :
+// utilisé par la tâche heartbeat et par le simulateur de flotte (tools/fleet/).
+
+// Commandes reçues dans la réponse ; les chaînes pointent dans le document parsé
+struct HeartbeatResponse
+{
+    bool debug;
+    const char *firmwareUrl;
+    const char *modelUrl;
+    bool traceRequested;
+    const char *ingestEndpoints[INGEST_MAX_ENDPOINTS];
+    int ingestEndpointCount; // 0 si le serveur n'a pas assigné de liste
+};
+
+// Construire le payload ; si buffer est non nul, ses enregistrements sont ajoutés puis il est vidé.
+// Retourne le nombre d'enregistrements ajoutés.
+int heartbeatBuildPayload(JsonDocument &doc, const char *uuid, SensorBuffer *buffer);
+
+// Lire la réponse du serveur (false si le JSON est invalide)
+bool heartbeatParseResponse(JsonDocument &doc, const char *body, size_t length, HeartbeatResponse &response);
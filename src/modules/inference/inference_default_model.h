@@ -0,0 +1,23 @@
+// AUTO GENERATED FILE, DO NOT EDIT (tools/model_pack.py)
+#pragma once
+#include <stdint.h>
+
+// Modèle par défaut "default" v1, classes : calme, bruit, gaz
+static const uint8_t INFERENCE_DEFAULT_MODEL[] = {
+    0x50, 0x4D, 0x44, 0x4C, 0x01, 0x00, 0x01, 0x00, 0x02, 0x0F, 0x03, 0x02, 0xDE, 0x00, 0x00, 0x00,
+    0x64, 0x7B, 0x2F, 0x89, 0x00, 0x00, 0x80, 0x3E, 0x00, 0x00, 0xC8, 0x43, 0x00, 0x00, 0x00, 0x40,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x40, 0x00, 0x00, 0xF0, 0x41, 0x00, 0x00, 0x20, 0x41,
+    0x00, 0x00, 0x00, 0x00, 0xCD, 0xCC, 0xCC, 0x3D, 0x00, 0x00, 0x7A, 0x44, 0x00, 0x00, 0x00, 0x3F,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x80, 0x40, 0x00, 0x00, 0x48, 0x42, 0x00, 0x00, 0x80, 0x40,
+    0x00, 0x00, 0x48, 0x42, 0x8F, 0xC2, 0x75, 0x3D, 0x00, 0x00, 0xFA, 0x44, 0x00, 0x00, 0x7A, 0x43,
+    0x00, 0x00, 0x00, 0x3F, 0x00, 0x00, 0x00, 0x40, 0x00, 0x00, 0x70, 0x42, 0x00, 0x00, 0x00, 0x40,
+    0x00, 0x00, 0x70, 0x42, 0x00, 0x00, 0x00, 0x40, 0x00, 0x00, 0x70, 0x42, 0x00, 0x00, 0x00, 0x40,
+    0x00, 0x00, 0x70, 0x42, 0x00, 0x00, 0x00, 0x40, 0x00, 0x00, 0x70, 0x42, 0x00, 0x00, 0x00, 0x39,
+    0x05, 0x00, 0x05, 0x14, 0x01, 0x00, 0x02, 0x00, 0x03, 0x14, 0x03, 0x00, 0x04, 0x00, 0xFF, 0x00,
+    0x01, 0x00, 0x00, 0x00, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0x00, 0x01, 0x00, 0x00, 0x00,
+    0x02, 0x00, 0x00, 0x10, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x10, 0x05, 0x00,
+    0x07, 0x28, 0x01, 0x00, 0x02, 0x00, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0x09, 0x00, 0x03, 0x00,
+    0x04, 0x00, 0xFF, 0x00, 0x01, 0x00, 0x00, 0x00, 0xFF, 0x00, 0x02, 0x00, 0x00, 0x00, 0x03, 0x00,
+    0x00, 0x10, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x10, 0x00, 0x00, 0x00, 0x02, 0x00, 0x0E,
+    0x00, 0x00,
+};
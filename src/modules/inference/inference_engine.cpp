@@ -0,0 +1,345 @@
+#include "inference_engine.h"
+#include <math.h>
+#include <string.h>
+
+static const size_t HEADER_SIZE = 20;
+static const size_t DENSE_HEADER_SIZE = 8;
+static const size_t TREE_NODE_SIZE = 6;
+
+// ======== LECTURE PETIT-BOUTISTE (blob non aligné) ========
+
+static inline uint16_t readU16(const uint8_t *p)
+{
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static inline int16_t readI16(const uint8_t *p)
+{
+    return (int16_t)readU16(p);
+}
+
+static inline uint32_t readU32(const uint8_t *p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static inline int32_t readI32(const uint8_t *p)
+{
+    return (int32_t)readU32(p);
+}
+
+static inline float readF32(const uint8_t *p)
+{
+    uint32_t bits = readU32(p);
+    float value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+static inline int8_t clampInt8(int32_t value)
+{
+    return value < -128 ? -128 : (value > 127 ? 127 : (int8_t)value);
+}
+
+// ======== CRC ========
+
+uint32_t inferenceCrc32(const uint8_t *data, size_t size)
+{
+    uint32_t crc = 0xFFFFFFFF;
+    for (size_t i = 0; i < size; i++)
+    {
+        crc ^= data[i];
+        for (int bit = 0; bit < 8; bit++)
+            crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1)));
+    }
+    return ~crc;
+}
+
+// ======== VALIDATION ========
+
+static size_t denseSectionSize(const uint8_t *p)
+{
+    return DENSE_HEADER_SIZE + (size_t)p[0] * p[1] + 4 * (size_t)p[1];
+}
+
+static InferenceStatus validateDense(const InferenceModel &model, const uint8_t *p, size_t remaining,
+                                     uint8_t expectedIn, bool last, size_t &sectionSize)
+{
+    if (remaining < DENSE_HEADER_SIZE)
+        return INFERENCE_ERR_SIZE;
+
+    uint8_t in = p[0];
+    uint8_t out = p[1];
+    uint8_t shift = p[3];
+    if (in != expectedIn || out == 0 || out > INFERENCE_MAX_WIDTH || shift > 31)
+        return INFERENCE_ERR_SHAPE;
+    if (p[2] > INFERENCE_ACTIVATION_RELU)
+        return INFERENCE_ERR_SHAPE;
+    if (last && out != model.classCount)
+        return INFERENCE_ERR_SHAPE;
+
+    sectionSize = denseSectionSize(p);
+    return sectionSize <= remaining ? INFERENCE_OK : INFERENCE_ERR_SIZE;
+}
+
+static InferenceStatus validateTree(const InferenceModel &model, const uint8_t *p, size_t remaining, size_t &sectionSize)
+{
+    if (remaining < 2)
+        return INFERENCE_ERR_SIZE;
+
+    uint16_t nodeCount = readU16(p);
+    size_t nodesEnd = 2 + (size_t)nodeCount * TREE_NODE_SIZE;
+    if (nodeCount == 0 || remaining < nodesEnd + 2)
+        return INFERENCE_ERR_SIZE;
+
+    uint16_t leafCount = readU16(p + nodesEnd);
+    sectionSize = nodesEnd + 2 + (size_t)leafCount * model.classCount * 2;
+    if (sectionSize > remaining)
+        return INFERENCE_ERR_SIZE;
+
+    // Les enfants pointent toujours vers un index plus grand : pas de cycle possible
+    for (uint16_t n = 0; n < nodeCount; n++)
+    {
+        const uint8_t *node = p + 2 + (size_t)n * TREE_NODE_SIZE;
+        int8_t feature = (int8_t)node[0];
+        uint16_t a = readU16(node + 2);
+        uint16_t b = readU16(node + 4);
+
+        if (feature < 0)
+        {
+            if (a >= leafCount)
+                return INFERENCE_ERR_TREE;
+        }
+        else if (feature >= model.inputCount || a <= n || b <= n || a >= nodeCount || b >= nodeCount)
+        {
+            return INFERENCE_ERR_TREE;
+        }
+    }
+    return INFERENCE_OK;
+}
+
+InferenceStatus inferenceModelLoad(InferenceModel &model, const uint8_t *blob, size_t size)
+{
+    if (blob == NULL || size < HEADER_SIZE)
+        return INFERENCE_ERR_SIZE;
+    if (memcmp(blob, "PMDL", 4) != 0)
+        return INFERENCE_ERR_MAGIC;
+    if (readU16(blob + 4) != INFERENCE_FORMAT_VERSION)
+        return INFERENCE_ERR_VERSION;
+
+    InferenceModel candidate;
+    candidate.modelVersion = readU16(blob + 6);
+    candidate.kind = blob[8];
+    candidate.inputCount = blob[9];
+    candidate.classCount = blob[10];
+    candidate.sectionCount = blob[11];
+    candidate.payloadSize = readU32(blob + 12);
+    candidate.payload = blob + HEADER_SIZE;
+
+    if (candidate.payloadSize > size - HEADER_SIZE)
+        return INFERENCE_ERR_SIZE;
+    if (inferenceCrc32(candidate.payload, candidate.payloadSize) != readU32(blob + 16))
+        return INFERENCE_ERR_CRC;
+    if (candidate.inputCount == 0 || candidate.inputCount > INFERENCE_MAX_INPUTS ||
+        candidate.classCount == 0 || candidate.classCount > INFERENCE_MAX_CLASSES ||
+        candidate.sectionCount == 0)
+        return INFERENCE_ERR_SHAPE;
+    if (candidate.kind != INFERENCE_KIND_DENSE && candidate.kind != INFERENCE_KIND_TREES)
+        return INFERENCE_ERR_VERSION;
+
+    size_t offset = (size_t)candidate.inputCount * 8;
+    if (offset + 4 > candidate.payloadSize)
+        return INFERENCE_ERR_SIZE;
+    candidate.outputScale = readF32(candidate.payload + offset);
+    offset += 4;
+
+    uint8_t width = candidate.inputCount;
+    for (uint8_t s = 0; s < candidate.sectionCount; s++)
+    {
+        size_t sectionSize = 0;
+        InferenceStatus status = candidate.kind == INFERENCE_KIND_DENSE
+                                     ? validateDense(candidate, candidate.payload + offset, candidate.payloadSize - offset,
+                                                     width, s == candidate.sectionCount - 1, sectionSize)
+                                     : validateTree(candidate, candidate.payload + offset, candidate.payloadSize - offset,
+                                                    sectionSize);
+        if (status != INFERENCE_OK)
+            return status;
+
+        if (candidate.kind == INFERENCE_KIND_DENSE)
+            width = candidate.payload[offset + 1];
+        offset += sectionSize;
+    }
+
+    if (offset != candidate.payloadSize)
+        return INFERENCE_ERR_SIZE;
+
+    model = candidate;
+    return INFERENCE_OK;
+}
+
+// ======== EXÉCUTION ========
+
+void inferenceQuantizeInputs(const InferenceModel &model, const float *features, int8_t *inputs)
+{
+    for (uint8_t i = 0; i < model.inputCount; i++)
+    {
+        float scale = readF32(model.payload + i * 8);
+        float offset = readF32(model.payload + i * 8 + 4);
+        float q = (features[i] - offset) * scale;
+        // Écrêtage avant la conversion (un flottant hors plage converti en int8 est indéfini) ;
+        // une caractéristique NaN prend le point zéro
+        if (isnan(q))
+            q = 0.0f;
+        q = q < -128.0f ? -128.0f : (q > 127.0f ? 127.0f : q);
+        inputs[i] = (int8_t)roundf(q);
+    }
+}
+
+// Multiplication virgule fixe : round(acc * multiplier / 2^(31 + shift))
+static inline int32_t requantize(int32_t acc, int32_t multiplier, uint8_t shift)
+{
+    int64_t product = (int64_t)acc * multiplier;
+    int totalShift = 31 + shift;
+    product += (int64_t)1 << (totalShift - 1);
+    return (int32_t)(product >> totalShift);
+}
+
+// Activations intermédiaires des couches denses (seule RAM statique du moteur)
+static int8_t activations[2][INFERENCE_MAX_WIDTH];
+
+static void runDense(const InferenceModel &model, const int8_t *inputs, int32_t *outputs)
+{
+    const int8_t *current = inputs;
+    const uint8_t *p = model.payload + (size_t)model.inputCount * 8 + 4;
+
+    for (uint8_t s = 0; s < model.sectionCount; s++)
+    {
+        uint8_t in = p[0];
+        uint8_t out = p[1];
+        uint8_t activation = p[2];
+        uint8_t shift = p[3];
+        int32_t multiplier = readI32(p + 4);
+        const int8_t *weights = (const int8_t *)(p + DENSE_HEADER_SIZE);
+        const uint8_t *bias = p + DENSE_HEADER_SIZE + (size_t)in * out;
+        bool last = s == model.sectionCount - 1;
+        int8_t *next = activations[s & 1];
+
+        for (uint8_t o = 0; o < out; o++)
+        {
+            int32_t acc = readI32(bias + 4 * o);
+            const int8_t *row = weights + (size_t)o * in;
+            for (uint8_t i = 0; i < in; i++)
+                acc += (int32_t)row[i] * current[i];
+
+            int32_t value = requantize(acc, multiplier, shift);
+            if (activation == INFERENCE_ACTIVATION_RELU && value < 0)
+                value = 0;
+
+            if (last)
+                outputs[o] = clampInt8(value);
+            else
+                next[o] = clampInt8(value);
+        }
+
+        current = next;
+        p += denseSectionSize(p);
+    }
+}
+
+static void runTrees(const InferenceModel &model, const int8_t *inputs, int32_t *outputs)
+{
+    const uint8_t *p = model.payload + (size_t)model.inputCount * 8 + 4;
+
+    for (uint8_t c = 0; c < model.classCount; c++)
+        outputs[c] = 0;
+
+    for (uint8_t s = 0; s < model.sectionCount; s++)
+    {
+        uint16_t nodeCount = readU16(p);
+        const uint8_t *nodes = p + 2;
+        const uint8_t *leaves = nodes + (size_t)nodeCount * TREE_NODE_SIZE + 2;
+        uint16_t leafCount = readU16(leaves - 2);
+
+        // Descente : les index sont strictement croissants (vérifié au chargement)
+        const uint8_t *node = nodes;
+        while ((int8_t)node[0] >= 0)
+        {
+            uint16_t nextIndex = inputs[node[0]] <= (int8_t)node[1] ? readU16(node + 2) : readU16(node + 4);
+            node = nodes + (size_t)nextIndex * TREE_NODE_SIZE;
+        }
+
+        const uint8_t *leaf = leaves + (size_t)readU16(node + 2) * model.classCount * 2;
+        for (uint8_t c = 0; c < model.classCount; c++)
+            outputs[c] += readI16(leaf + 2 * c);
+
+        p = leaves + (size_t)leafCount * model.classCount * 2;
+    }
+}
+
+size_t inferenceStaticRamSize()
+{
+    return sizeof(activations);
+}
+
+void inferenceRun(const InferenceModel &model, const int8_t *inputs, int32_t *outputs)
+{
+    if (model.kind == INFERENCE_KIND_DENSE)
+        runDense(model, inputs, outputs);
+    else
+        runTrees(model, inputs, outputs);
+}
+
+void inferenceOutputsToProbabilities(const InferenceModel &model, const int32_t *outputs, float *probabilities)
+{
+    float sum = 0.0f;
+
+    if (model.kind == INFERENCE_KIND_DENSE)
+    {
+        // Softmax des logits déquantifiés
+        int32_t maxOutput = outputs[0];
+        for (uint8_t c = 1; c < model.classCount; c++)
+            if (outputs[c] > maxOutput)
+                maxOutput = outputs[c];
+
+        for (uint8_t c = 0; c < model.classCount; c++)
+        {
+            probabilities[c] = expf((outputs[c] - maxOutput) * model.outputScale);
+            sum += probabilities[c];
+        }
+    }
+    else
+    {
+        // Ensemble d'arbres : scores cumulés normalisés
+        for (uint8_t c = 0; c < model.classCount; c++)
+        {
+            float score = outputs[c] * model.outputScale;
+            probabilities[c] = score > 0.0f ? score : 0.0f;
+            sum += probabilities[c];
+        }
+    }
+
+    for (uint8_t c = 0; c < model.classCount; c++)
+        probabilities[c] = sum > 0.0f ? probabilities[c] / sum : 1.0f / model.classCount;
+}
+
+const char *inferenceStatusToString(InferenceStatus status)
+{
+    switch (status)
+    {
+    case INFERENCE_OK:
+        return "ok";
+    case INFERENCE_ERR_SIZE:
+        return "taille invalide";
+    case INFERENCE_ERR_MAGIC:
+        return "signature invalide";
+    case INFERENCE_ERR_VERSION:
+        return "version non supportée";
+    case INFERENCE_ERR_CRC:
+        return "CRC invalide";
+    case INFERENCE_ERR_SHAPE:
+        return "dimensions invalides";
+    case INFERENCE_ERR_TREE:
+        return "arbre invalide";
+    }
+    return "inconnu";
+}
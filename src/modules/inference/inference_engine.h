@@ -0,0 +1,79 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+
+// ======== CONFIGURATION ========
+#define INFERENCE_MAX_WIDTH 64   // Largeur max d'une couche dense (activations int8)
+#define INFERENCE_MAX_CLASSES 8  // Nombre max de classes
+#define INFERENCE_MAX_INPUTS 32  // Nombre max d'entrées
+#define INFERENCE_FORMAT_VERSION 1
+
+// ======== FORMAT DU BLOB (petit-boutiste) ========
+// En-tête (20 octets) :
+//   "PMDL" | u16 formatVersion | u16 modelVersion | u8 kind | u8 inputCount
+//   | u8 classCount | u8 sectionCount | u32 payloadSize | u32 payloadCrc32
+// Charge utile :
+//   inputCount x (f32 scale, f32 offset)   q = clamp(round((x - offset) * scale), -128, 127)
+//   f32 outputScale                         sortie réelle = sortie entière * outputScale
+//   sectionCount sections :
+//     dense : u8 in | u8 out | u8 activation | u8 shift | i32 multiplier (Q31)
+//             | i8 weights[out][in] | i32 bias[out]
+//     arbre : u16 nodeCount | nodeCount x (i8 feature | i8 threshold | u16 a | u16 b)
+//             | u16 leafCount | i16 leafValues[leafCount][classCount]
+//             feature < 0 : feuille d'index a ; sinon gauche (a) si entrée <= threshold, droite (b) sinon
+enum InferenceModelKind : uint8_t
+{
+    INFERENCE_KIND_DENSE = 1,
+    INFERENCE_KIND_TREES = 2,
+};
+
+enum InferenceActivation : uint8_t
+{
+    INFERENCE_ACTIVATION_NONE = 0,
+    INFERENCE_ACTIVATION_RELU = 1,
+};
+
+enum InferenceStatus
+{
+    INFERENCE_OK = 0,
+    INFERENCE_ERR_SIZE,
+    INFERENCE_ERR_MAGIC,
+    INFERENCE_ERR_VERSION,
+    INFERENCE_ERR_CRC,
+    INFERENCE_ERR_SHAPE,
+    INFERENCE_ERR_TREE,
+};
+
+// Modèle validé ; pointe directement dans le blob (aucune copie, le blob peut rester en flash)
+struct InferenceModel
+{
+    const uint8_t *payload;
+    uint32_t payloadSize;
+    uint16_t modelVersion;
+    uint8_t kind;
+    uint8_t inputCount;
+    uint8_t classCount;
+    uint8_t sectionCount;
+    float outputScale;
+};
+
+// Valider un blob et préparer le modèle
+InferenceStatus inferenceModelLoad(InferenceModel &model, const uint8_t *blob, size_t size);
+
+// Quantifier les caractéristiques réelles en entrées int8 (écrêtées ; NaN donne le point zéro, 0)
+void inferenceQuantizeInputs(const InferenceModel &model, const float *features, int8_t *inputs);
+
+// Exécuter le modèle ; outputs reçoit classCount valeurs entières (bit-exactes sur toutes les cibles)
+void inferenceRun(const InferenceModel &model, const int8_t *inputs, int32_t *outputs);
+
+// RAM statique utilisée par le moteur (octets)
+size_t inferenceStaticRamSize();
+
+// Convertir les sorties entières en probabilités de classes
+void inferenceOutputsToProbabilities(const InferenceModel &model, const int32_t *outputs, float *probabilities);
+
+// CRC32 (IEEE 802.3) utilisé pour la charge utile
+uint32_t inferenceCrc32(const uint8_t *data, size_t size);
+
+// Texte d'un statut (pour les logs)
+const char *inferenceStatusToString(InferenceStatus status);
@@ -0,0 +1,343 @@
+#include "inference_manager.h"
+#include "inference_engine.h"
+#include "inference_default_model.h"
+#include <HTTPClient.h>
+#include <esp_partition.h>
+#include <modules/sensors/sensor_buffer.h>
+#include <modules/wifi/wifi_manager.h>
+#include <modules/log/log_manager.h>
+#include <modules/tls/tls_client.h>
+
+static InferenceModel model;
+static const esp_partition_t *modelPartition = NULL;
+static spi_flash_mmap_handle_t modelMmapHandle = 0;
+static bool modelMapped = false;
+
+static char modelUrl[256] = "";
+static volatile bool modelUpdateRequested = false;
+
+// Téléchargement dans une tâche dédiée : la loop (échantillonnage, SSE, écran) n'est pas bloquée
+enum ModelDownloadState : uint8_t
+{
+    MODEL_DOWNLOAD_IDLE = 0,
+    MODEL_DOWNLOAD_RUNNING,
+    MODEL_DOWNLOAD_DONE,   // blob écrit dans la partition, à charger depuis la loop
+    MODEL_DOWNLOAD_FAILED,
+};
+
+static volatile ModelDownloadState downloadState = MODEL_DOWNLOAD_IDLE;
+static char downloadUrl[sizeof(modelUrl)];
+
+// Fenêtre glissante des lectures au rythme plein
+static SensorRecord window[INFERENCE_WINDOW_SIZE];
+static int windowCount = 0;
+static int windowNext = 0;
+static uint32_t lastReadingCount = 0;
+static unsigned long lastInferenceTime = 0;
+
+// Dernier résultat, lu par la tâche heartbeat
+static portMUX_TYPE resultMux = portMUX_INITIALIZER_UNLOCKED;
+static float probabilities[INFERENCE_MAX_CLASSES];
+static uint8_t resultClassCount = 0;
+static uint16_t resultModelVersion = 0;
+static uint32_t lastInferenceUs = 0;
+
+// ======== CHARGEMENT DU MODÈLE ========
+
+static void unmapModelPartition()
+{
+    if (modelMapped)
+    {
+        spi_flash_munmap(modelMmapHandle);
+        modelMapped = false;
+    }
+}
+
+static void loadDefaultModel()
+{
+    InferenceStatus status = inferenceModelLoad(model, INFERENCE_DEFAULT_MODEL, sizeof(INFERENCE_DEFAULT_MODEL));
+    LOG_INFO("Inference Manager: Modèle intégré v%d (%s)\n", model.modelVersion, inferenceStatusToString(status));
+}
+
+// Projeter la partition en mémoire et valider le blob qu'elle contient
+static bool loadPartitionModel()
+{
+    if (modelPartition == NULL)
+        return false;
+
+    const void *blob = NULL;
+    if (esp_partition_mmap(modelPartition, 0, modelPartition->size, SPI_FLASH_MMAP_DATA, &blob, &modelMmapHandle) != ESP_OK)
+        return false;
+    modelMapped = true;
+
+    InferenceModel candidate;
+    InferenceStatus status = inferenceModelLoad(candidate, (const uint8_t *)blob, modelPartition->size);
+    if (status != INFERENCE_OK)
+    {
+        LOG_WARN("Inference Manager: Partition modèle ignorée (%s)\n", inferenceStatusToString(status));
+        unmapModelPartition();
+        return false;
+    }
+
+    model = candidate;
+    LOG_INFO("Inference Manager: Modèle v%d chargé depuis la flash\n", model.modelVersion);
+    return true;
+}
+
+// Télécharger un blob dans la partition "model" (tâche dédiée, core 0).
+// La loop est déjà passée sur le modèle intégré : la partition n'est plus lue pendant l'écriture.
+// modified : la partition a été (au moins en partie) effacée
+static bool downloadModel(const char *url, bool &modified)
+{
+    WiFiClient plainClient;
+    TlsClient tlsClient;
+    bool secure = strncmp(url, "https://", 8) == 0;
+
+    HTTPClient http;
+    http.begin(secure ? (WiFiClient &)tlsClient : plainClient, url);
+    http.setTimeout(INFERENCE_DOWNLOAD_TIMEOUT);
+    int httpCode = http.GET();
+    int size = http.getSize();
+
+    if (httpCode != 200 || size <= 0 || (uint32_t)size > modelPartition->size)
+    {
+        LOG_WARN("Inference Manager: Téléchargement du modèle échoué (HTTP %d, %d octets)\n", httpCode, size);
+        http.end();
+        return false;
+    }
+
+    WiFiClient *stream = http.getStreamPtr();
+    uint8_t chunk[256];
+    int written = 0;
+    size_t erased = 0;
+    esp_err_t err = ESP_OK;
+    unsigned long lastData = millis();
+
+    while (err == ESP_OK && written < size && millis() - lastData < INFERENCE_DOWNLOAD_TIMEOUT)
+    {
+        int available = stream->available();
+        if (available <= 0)
+        {
+            vTaskDelay(pdMS_TO_TICKS(10));
+            continue;
+        }
+        int len = stream->readBytes(chunk, min(min(available, (int)sizeof(chunk)), size - written));
+
+        // Effacement secteur par secteur, au fil de l'écriture : le cache flash n'est suspendu
+        // que le temps d'un secteur à la fois
+        while (err == ESP_OK && erased < (size_t)(written + len))
+        {
+            err = esp_partition_erase_range(modelPartition, erased, SPI_FLASH_SEC_SIZE);
+            erased += SPI_FLASH_SEC_SIZE;
+            modified = true;
+        }
+        if (err == ESP_OK)
+            err = esp_partition_write(modelPartition, written, chunk, len);
+        written += len;
+        lastData = millis();
+    }
+    http.end();
+
+    if (err != ESP_OK || written != size)
+    {
+        LOG_ERROR("Inference Manager: Modèle incomplet (%d/%d octets)\n", written, size);
+        return false;
+    }
+    return true;
+}
+
+static void modelDownloadTask(void *parameter)
+{
+    bool modified = false;
+    bool downloaded = downloadModel(downloadUrl, modified);
+    if (!downloaded && modified)
+    {
+        // Blob incomplet : on efface l'en-tête pour ne pas le recharger au démarrage
+        esp_partition_erase_range(modelPartition, 0, SPI_FLASH_SEC_SIZE);
+    }
+    downloadState = downloaded ? MODEL_DOWNLOAD_DONE : MODEL_DOWNLOAD_FAILED;
+    vTaskDelete(NULL);
+}
+
+// Lancer le téléchargement demandé, puis charger son résultat une fois la tâche terminée
+static void processModelUpdate()
+{
+    if (downloadState == MODEL_DOWNLOAD_DONE || downloadState == MODEL_DOWNLOAD_FAILED)
+    {
+        // Échec avant toute écriture : la partition contient toujours l'ancien modèle, rechargé ici
+        bool loaded = loadPartitionModel();
+        if (downloadState == MODEL_DOWNLOAD_DONE && !loaded)
+        {
+            LOG_ERROR("Inference Manager: Nouveau modèle invalide, modèle intégré conservé");
+            esp_partition_erase_range(modelPartition, 0, SPI_FLASH_SEC_SIZE);
+        }
+        downloadState = MODEL_DOWNLOAD_IDLE;
+    }
+
+    if (!modelUpdateRequested || downloadState != MODEL_DOWNLOAD_IDLE || !wifiManagerIsConnected())
+        return;
+    modelUpdateRequested = false;
+
+    if (modelPartition == NULL)
+    {
+        LOG_ERROR("Inference Manager: Pas de partition modèle, mise à jour impossible");
+        return;
+    }
+
+    // Le modèle courant peut résider dans la partition : on repasse sur le modèle intégré
+    loadDefaultModel();
+    unmapModelPartition();
+
+    strncpy(downloadUrl, modelUrl, sizeof(downloadUrl));
+    downloadState = MODEL_DOWNLOAD_RUNNING;
+
+    // Pile de 8 Ko comme la tâche heartbeat : le handshake TLS en a besoin
+    if (xTaskCreatePinnedToCore(modelDownloadTask, "ModelDownload", 8192, NULL, 1, NULL, 0) != pdPASS)
+    {
+        LOG_ERROR("Inference Manager: Impossible de créer la tâche de téléchargement");
+        downloadState = MODEL_DOWNLOAD_FAILED;
+    }
+}
+
+// ======== CARACTÉRISTIQUES ========
+
+// Moyennes, pentes et niveaux sur la fenêtre, dans l'ordre attendu par les modèles
+static void computeFeatures(float *features)
+{
+    const SensorRecord &first = window[windowNext % INFERENCE_WINDOW_SIZE];
+    const SensorRecord &last = window[(windowNext + INFERENCE_WINDOW_SIZE - 1) % INFERENCE_WINDOW_SIZE];
+    float duration = (last.timestamp - first.timestamp) / 1000.0f;
+    if (duration <= 0.0f)
+        duration = 1.0f;
+
+    float sums[4] = {0, 0, 0, 0};
+    float micMax = -1000.0f;
+    float centroid = 0.0f;
+    float flatness = 0.0f;
+    float bands[ACOUSTIC_BAND_COUNT] = {0};
+    int featureCount = 0;
+
+    for (int i = 0; i < INFERENCE_WINDOW_SIZE; i++)
+    {
+        const SensorRecord &r = window[i];
+        sums[0] += r.mq135_ppm;
+        sums[1] += r.mq136_ppm;
+        sums[2] += r.mq4_ppm;
+        sums[3] += r.mic_db;
+        micMax = max(micMax, r.mic_db);
+        if (r.channels & CHANNEL_MIC_FEATURES)
+        {
+            centroid += r.mic_features.centroidHz;
+            flatness += r.mic_features.flatness;
+            for (int b = 0; b < ACOUSTIC_BAND_COUNT; b++)
+                bands[b] += r.mic_features.bandDb[b];
+            featureCount++;
+        }
+    }
+
+    features[0] = sums[0] / INFERENCE_WINDOW_SIZE;
+    features[1] = (last.mq135_ppm - first.mq135_ppm) / duration;
+    features[2] = sums[1] / INFERENCE_WINDOW_SIZE;
+    features[3] = (last.mq136_ppm - first.mq136_ppm) / duration;
+    features[4] = sums[2] / INFERENCE_WINDOW_SIZE;
+    features[5] = (last.mq4_ppm - first.mq4_ppm) / duration;
+    features[6] = sums[3] / INFERENCE_WINDOW_SIZE;
+    features[7] = micMax;
+    features[8] = featureCount > 0 ? centroid / featureCount : 0.0f;
+    features[9] = featureCount > 0 ? flatness / featureCount : 0.0f;
+    for (int b = 0; b < ACOUSTIC_BAND_COUNT; b++)
+        features[10 + b] = featureCount > 0 ? bands[b] / featureCount : 0.0f;
+}
+
+static void classify()
+{
+    if (model.inputCount != INFERENCE_FEATURE_COUNT)
+        return;
+
+    float features[INFERENCE_FEATURE_COUNT];
+    int8_t inputs[INFERENCE_FEATURE_COUNT];
+    int32_t outputs[INFERENCE_MAX_CLASSES];
+    float result[INFERENCE_MAX_CLASSES];
+
+    unsigned long start = micros();
+    computeFeatures(features);
+    inferenceQuantizeInputs(model, features, inputs);
+    inferenceRun(model, inputs, outputs);
+    inferenceOutputsToProbabilities(model, outputs, result);
+    lastInferenceUs = micros() - start;
+
+    portENTER_CRITICAL(&resultMux);
+    memcpy(probabilities, result, sizeof(probabilities));
+    resultClassCount = model.classCount;
+    resultModelVersion = model.modelVersion;
+    portEXIT_CRITICAL(&resultMux);
+}
+
+// ======== FONCTIONS PUBLIQUES ========
+
+void inferenceManagerInit()
+{
+    Serial.println("Inference Manager: Initialisation du moteur d'inférence...");
+
+    modelPartition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA,
+                                              (esp_partition_subtype_t)INFERENCE_MODEL_PARTITION_SUBTYPE,
+                                              INFERENCE_MODEL_PARTITION);
+    if (!loadPartitionModel())
+        loadDefaultModel();
+
+    Serial.printf("Inference Manager: RAM utilisée ~%u octets (fenêtre + activations)\n",
+                  (unsigned)(sizeof(window) + inferenceStaticRamSize()));
+}
+
+void inferenceManagerProcess()
+{
+    processModelUpdate();
+
+    SensorRecord reading;
+    uint32_t readingCount = getLastSensorReading(reading);
+    if (readingCount != lastReadingCount)
+    {
+        lastReadingCount = readingCount;
+        window[windowNext] = reading;
+        windowNext = (windowNext + 1) % INFERENCE_WINDOW_SIZE;
+        if (windowCount < INFERENCE_WINDOW_SIZE)
+            windowCount++;
+    }
+
+    if (windowCount == INFERENCE_WINDOW_SIZE && millis() - lastInferenceTime >= INFERENCE_INTERVAL)
+    {
+        lastInferenceTime = millis();
+        classify();
+    }
+}
+
+void inferenceManagerSetModelUrl(const char *url)
+{
+    strncpy(modelUrl, url, sizeof(modelUrl) - 1);
+    modelUrl[sizeof(modelUrl) - 1] = '\0';
+    modelUpdateRequested = true;
+    LOG_INFO("Inference Manager: Mise à jour du modèle demandée: %s\n", modelUrl);
+}
+
+void inferenceManagerAddToJson(JsonDocument &doc)
+{
+    float result[INFERENCE_MAX_CLASSES];
+    uint8_t classCount;
+    uint16_t modelVersion;
+
+    portENTER_CRITICAL(&resultMux);
+    memcpy(result, probabilities, sizeof(result));
+    classCount = resultClassCount;
+    modelVersion = resultModelVersion;
+    portEXIT_CRITICAL(&resultMux);
+
+    if (classCount == 0)
+        return;
+
+    JsonObject classification = doc.createNestedObject("classification");
+    classification["modelVersion"] = modelVersion;
+    classification["inferenceUs"] = lastInferenceUs;
+    JsonArray probs = classification.createNestedArray("probabilities");
+    for (uint8_t c = 0; c < classCount; c++)
+        probs.add(result[c]);
+}
@@ -0,0 +1,24 @@
+#pragma once
+#include <Arduino.h>
+#include <ArduinoJson.h>
+
+// ======== CONFIGURATION ========
+#define INFERENCE_WINDOW_SIZE 20       // Fenêtre glissante de lectures (20 x 100 ms)
+#define INFERENCE_INTERVAL 1000        // Période de classification (ms)
+#define INFERENCE_FEATURE_COUNT 15     // Entrées attendues par le modèle
+#define INFERENCE_MODEL_PARTITION "model"
+#define INFERENCE_MODEL_PARTITION_SUBTYPE 0x40
+#define INFERENCE_DOWNLOAD_TIMEOUT 5000 // Timeout HTTP et délai max sans données pendant le téléchargement (ms)
+
+// Classification embarquée des événements (gaz + micro) :
+// modèle int8 (couches denses ou ensemble d'arbres) lu directement en flash,
+// partition "model" si elle contient un blob valide, modèle intégré au firmware sinon.
+void inferenceManagerInit();
+void inferenceManagerProcess();
+
+// Demander le téléchargement d'un nouveau modèle (http ou https, tâche dédiée ;
+// le modèle intégré est utilisé pendant l'écriture de la partition)
+void inferenceManagerSetModelUrl(const char *url);
+
+// Ajouter la dernière classification au payload du heartbeat
+void inferenceManagerAddToJson(JsonDocument &doc);
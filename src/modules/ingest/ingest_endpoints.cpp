@@ -0,0 +1,195 @@
+#include "ingest_endpoints.h"
+#include <string.h>
+#include <modules/log/log_manager.h>
+
+// Taux d'échec après une série d'échecs consécutifs, en partant de rate
+static constexpr float failureRateAfter(float rate, int failures)
+{
+    return failures == 0 ? rate : failureRateAfter(rate + INGEST_EWMA_ALPHA * (1.0f - rate), failures - 1);
+}
+
+// Le taux d'échec ne dégrade pas avant la règle des échecs consécutifs, y compris depuis
+// l'historique neutre d'un endpoint qui revient d'éviction
+static_assert(failureRateAfter(INGEST_FAILURE_RATE_DEGRADED / 2, INGEST_MAX_CONSECUTIVE_FAILURES - 1) <=
+                  INGEST_FAILURE_RATE_DEGRADED,
+              "INGEST_FAILURE_RATE_DEGRADED atteint avant INGEST_MAX_CONSECUTIVE_FAILURES");
+
+// ======== HACHAGE ========
+
+static uint64_t fnv1a64(const char *text)
+{
+    uint64_t hash = 0xCBF29CE484222325ULL;
+    while (*text)
+    {
+        hash ^= (uint8_t)*text++;
+        hash *= 0x100000001B3ULL;
+    }
+    return hash;
+}
+
+// Finaliseur splitmix64 : répartit uniformément les scores HRW
+static uint64_t mix64(uint64_t value)
+{
+    value ^= value >> 30;
+    value *= 0xBF58476D1CE4E5B9ULL;
+    value ^= value >> 27;
+    value *= 0x94D049BB133111EBULL;
+    value ^= value >> 31;
+    return value;
+}
+
+static void resetEndpoint(IngestEndpoint &endpoint, const char *url, uint64_t deviceHash)
+{
+    memset(&endpoint, 0, sizeof(endpoint));
+    strcpy(endpoint.url, url); // longueur vérifiée par ingestSetEndpoints
+    endpoint.rendezvousScore = mix64(deviceHash ^ fnv1a64(endpoint.url));
+}
+
+// ======== LISTE ========
+
+void ingestInit(IngestEndpointSet &set, const char *deviceId)
+{
+    memset(&set, 0, sizeof(set));
+    set.deviceHash = fnv1a64(deviceId);
+    set.selected = -1;
+}
+
+bool ingestSetEndpoints(IngestEndpointSet &set, const char *const *urls, int count)
+{
+    // Une URL tronquée enverrait les heartbeats vers un autre hôte ou chemin : rejetée
+    const char *accepted[INGEST_MAX_ENDPOINTS];
+    int acceptedCount = 0;
+    for (int i = 0; i < count && acceptedCount < INGEST_MAX_ENDPOINTS; i++)
+    {
+        size_t length = strlen(urls[i]);
+        if (length >= INGEST_URL_MAX)
+        {
+            LOG_WARN("Ingest: URL de %u caractères rejetée (max %d) : %.48s...\n",
+                     (unsigned)length, INGEST_URL_MAX - 1, urls[i]);
+            continue;
+        }
+        accepted[acceptedCount++] = urls[i];
+    }
+    if (acceptedCount == 0 && count > 0)
+        return false;
+    urls = accepted;
+    count = acceptedCount;
+
+    bool changed = count != set.count;
+    for (int i = 0; i < count && !changed; i++)
+        changed = strcmp(set.endpoints[i].url, urls[i]) != 0;
+    if (!changed)
+        return false;
+
+    IngestEndpoint previous[INGEST_MAX_ENDPOINTS];
+    int previousCount = set.count;
+    int previousSelected = set.selected;
+    memcpy(previous, set.endpoints, sizeof(previous));
+
+    // L'endpoint en cours suit son URL ; retiré de la liste, il n'y a plus de sélection
+    set.selected = -1;
+    for (int i = 0; i < count; i++)
+    {
+        resetEndpoint(set.endpoints[i], urls[i], set.deviceHash);
+        for (int j = 0; j < previousCount; j++)
+        {
+            if (strcmp(previous[j].url, set.endpoints[i].url) == 0)
+            {
+                set.endpoints[i] = previous[j];
+                if (j == previousSelected)
+                    set.selected = i;
+                break;
+            }
+        }
+    }
+    set.count = count;
+    return true;
+}
+
+// ======== SANTÉ ========
+
+IngestHealth ingestGetHealth(const IngestEndpoint &endpoint)
+{
+    if (endpoint.down)
+        return INGEST_DOWN;
+    if (endpoint.latencyEwmaMs > INGEST_LATENCY_DEGRADED_MS || endpoint.failureRateEwma > INGEST_FAILURE_RATE_DEGRADED)
+        return INGEST_DEGRADED;
+    return INGEST_HEALTHY;
+}
+
+int ingestSelect(IngestEndpointSet &set, uint32_t now)
+{
+    // Fin d'éviction : un endpoint en panne, ou dégradé et donc plus utilisé par ce device,
+    // repasse à l'essai avec un historique neutre (sinon il ne serait jamais réévalué)
+    for (int i = 0; i < set.count; i++)
+    {
+        IngestEndpoint &endpoint = set.endpoints[i];
+        if (ingestGetHealth(endpoint) != INGEST_HEALTHY && now - endpoint.lastReportTime >= INGEST_COOLDOWN_MS)
+        {
+            endpoint.down = false;
+            endpoint.consecutiveFailures = 0;
+            endpoint.consecutiveTimeouts = 0;
+            endpoint.latencyEwmaMs = 0;
+            endpoint.failureRateEwma = INGEST_FAILURE_RATE_DEGRADED / 2;
+        }
+    }
+
+    // Meilleur score HRW dans la meilleure classe de santé disponible
+    int best = -1;
+    IngestHealth bestHealth = INGEST_DOWN;
+    for (int i = 0; i < set.count; i++)
+    {
+        IngestHealth health = ingestGetHealth(set.endpoints[i]);
+        if (best < 0 || health < bestHealth ||
+            (health == bestHealth && set.endpoints[i].rendezvousScore > set.endpoints[best].rendezvousScore))
+        {
+            best = i;
+            bestHealth = health;
+        }
+    }
+
+    // Bascule : l'endpoint quitté sortait d'échecs (en panne, ou dégradé par son taux d'échec).
+    // Une réaffectation par le serveur ou un délaissement pour latence n'en est pas une.
+    if (set.selected >= 0 && best != set.selected && set.endpoints[set.selected].consecutiveFailures > 0)
+        set.failovers++;
+    set.selected = best;
+    return best;
+}
+
+void ingestReportSuccess(IngestEndpointSet &set, int index, uint32_t latencyMs, uint32_t now)
+{
+    if (index < 0 || index >= set.count)
+        return;
+
+    IngestEndpoint &endpoint = set.endpoints[index];
+    endpoint.requests++;
+    endpoint.consecutiveFailures = 0;
+    endpoint.consecutiveTimeouts = 0;
+    endpoint.lastReportTime = now;
+    endpoint.latencyEwmaMs = endpoint.latencyEwmaMs == 0
+                                 ? latencyMs
+                                 : endpoint.latencyEwmaMs + INGEST_EWMA_ALPHA * (latencyMs - endpoint.latencyEwmaMs);
+    endpoint.failureRateEwma *= 1.0f - INGEST_EWMA_ALPHA;
+}
+
+void ingestReportFailure(IngestEndpointSet &set, int index, bool timeout, uint32_t now)
+{
+    if (index < 0 || index >= set.count)
+        return;
+
+    IngestEndpoint &endpoint = set.endpoints[index];
+    endpoint.requests++;
+    endpoint.failures++;
+    endpoint.lastReportTime = now;
+    endpoint.consecutiveFailures++;
+    if (timeout)
+        endpoint.consecutiveTimeouts++;
+    endpoint.failureRateEwma += INGEST_EWMA_ALPHA * (1.0f - endpoint.failureRateEwma);
+
+    // Bascule rapide
+    if (endpoint.consecutiveFailures >= INGEST_MAX_CONSECUTIVE_FAILURES ||
+        endpoint.consecutiveTimeouts >= INGEST_MAX_CONSECUTIVE_TIMEOUTS)
+    {
+        endpoint.down = true;
+    }
+}
@@ -0,0 +1,69 @@
+#pragma once
+#include <stdint.h>
+
+// ======== CONFIGURATION ========
+#define INGEST_MAX_ENDPOINTS 4
+#define INGEST_URL_MAX 128                   // Taille du buffer d'URL, zéro final compris
+#define INGEST_EWMA_ALPHA 0.15f              // Poids d'une nouvelle mesure dans les moyennes glissantes
+#define INGEST_LATENCY_DEGRADED_MS 1500.0f   // Latence moyenne au-delà de laquelle l'endpoint est dégradé
+// Taux d'échec moyen au-delà duquel l'endpoint est dégradé : vise un échec sur deux soutenu ;
+// des échecs consécutifs ne l'atteignent pas avant INGEST_MAX_CONSECUTIVE_FAILURES (vérifié
+// à la compilation), deux 503 isolés ne délaissent donc pas un endpoint sain
+#define INGEST_FAILURE_RATE_DEGRADED 0.5f
+#define INGEST_MAX_CONSECUTIVE_FAILURES 3    // Échecs consécutifs avant bascule
+#define INGEST_MAX_CONSECUTIVE_TIMEOUTS 2    // Timeouts consécutifs avant bascule (plus coûteux)
+#define INGEST_COOLDOWN_MS 60000             // Durée d'éviction d'un endpoint en panne ou délaissé car dégradé
+
+// Santé d'un endpoint d'ingestion, telle que vue par ce device
+enum IngestHealth : uint8_t
+{
+    INGEST_HEALTHY = 0,
+    INGEST_DEGRADED = 1,
+    INGEST_DOWN = 2,
+};
+
+struct IngestEndpoint
+{
+    char url[INGEST_URL_MAX];
+    uint64_t rendezvousScore; // poids HRW de ce device pour cet endpoint
+    float latencyEwmaMs;
+    float failureRateEwma;
+    uint8_t consecutiveFailures;
+    uint8_t consecutiveTimeouts;
+    bool down;
+    uint32_t lastReportTime; // ms, dernier résultat reçu
+    uint32_t requests;
+    uint32_t failures;
+};
+
+// Choix déterministe par hachage de rendez-vous (HRW) sur l'identifiant du device :
+// chaque device classe les endpoints selon hash(device, url) et prend le meilleur
+// parmi les plus sains. La charge se répartit uniformément et, quand un endpoint
+// tombe, seuls les devices qui l'utilisaient sont déplacés.
+struct IngestEndpointSet
+{
+    IngestEndpoint endpoints[INGEST_MAX_ENDPOINTS];
+    int count;
+    uint64_t deviceHash;
+    int selected;       // dernier endpoint retourné par ingestSelect (-1 : aucun)
+    uint32_t failovers; // bascules parce que l'endpoint utilisé échouait
+};
+
+void ingestInit(IngestEndpointSet &set, const char *deviceId);
+
+// Remplacer la liste (config ou serveur) ; la santé des URL conservées est gardée.
+// Une réaffectation par le serveur n'est pas une bascule. Une URL de INGEST_URL_MAX caractères
+// ou plus est rejetée (tronquée, elle viserait un autre hôte ou chemin) ; une liste sans URL
+// valide laisse la liste en cours. Retourne false si la liste n'a pas changé.
+bool ingestSetEndpoints(IngestEndpointSet &set, const char *const *urls, int count);
+
+// Index de l'endpoint à utiliser maintenant (-1 si la liste est vide).
+// Compte une bascule quand l'endpoint précédent est quitté à la suite d'échecs signalés
+// par ingestReportFailure (en panne, ou dégradé par un taux d'échec soutenu).
+int ingestSelect(IngestEndpointSet &set, uint32_t now);
+
+// Résultat d'une requête vers un endpoint
+void ingestReportSuccess(IngestEndpointSet &set, int index, uint32_t latencyMs, uint32_t now);
+void ingestReportFailure(IngestEndpointSet &set, int index, bool timeout, uint32_t now);
+
+IngestHealth ingestGetHealth(const IngestEndpoint &endpoint);
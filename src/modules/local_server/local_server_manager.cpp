@@ -0,0 +1,273 @@
+#include "local_server_manager.h"
+#include <AsyncTCP.h>
+#include <ESPAsyncWebServer.h>
+#include <modules/sensors/sensor_buffer.h>
+#include <modules/heartbeat/heartbeat_manager.h>
+#include <modules/acoustic/acoustic_manager.h>
+#include <modules/log/log_manager.h>
+#include <modules/tls/tls_client.h>
+#include <modules/burst/burst_capture.h>
+
+static AsyncWebServer server(LOCAL_SERVER_PORT);
+static AsyncEventSource events("/events");
+
+// Réponses préformatées en double buffer : la loop écrit dans le buffer non publié puis le
+// publie ; une réponse en cours épingle son buffer, que la loop ne réécrit qu'une fois libéré.
+// Les handlers envoient directement depuis ces buffers statiques, sans copie ni allocation.
+struct PreformattedText
+{
+    char *text[2];
+    size_t capacity;
+    size_t length[2];
+    uint8_t readers[2]; // réponses en cours d'envoi depuis chaque buffer
+    uint8_t published;  // buffer servi aux nouvelles requêtes
+};
+
+static portMUX_TYPE snapshotMux = portMUX_INITIALIZER_UNLOCKED;
+static char metricsBuffers[2][3072];
+static char snapshotBuffers[2][192];
+static PreformattedText metricsText = {{metricsBuffers[0], metricsBuffers[1]}, sizeof(metricsBuffers[0])};
+static PreformattedText snapshotJson = {{snapshotBuffers[0], snapshotBuffers[1]}, sizeof(snapshotBuffers[0])};
+static char sampleEvent[160] = "";
+
+static uint32_t lastReadingCount = 0;
+static unsigned long lastSnapshotTime = 0;
+static volatile uint32_t loopTimeUs = 0;
+static uint32_t loopTimeMaxUs = 0;
+
+// ======== FORMATAGE ========
+
+// Buffer libre pour le prochain formatage (NULL si une réponse l'utilise encore)
+static char *beginFormat(PreformattedText &preformatted)
+{
+    int back = 1 - preformatted.published;
+    portENTER_CRITICAL(&snapshotMux);
+    bool busy = preformatted.readers[back] > 0;
+    portEXIT_CRITICAL(&snapshotMux);
+    return busy ? NULL : preformatted.text[back];
+}
+
+static void publishFormat(PreformattedText &preformatted, int length)
+{
+    int back = 1 - preformatted.published;
+    portENTER_CRITICAL(&snapshotMux);
+    preformatted.length[back] = min<size_t>(max(length, 0), preformatted.capacity - 1);
+    preformatted.published = back;
+    portEXIT_CRITICAL(&snapshotMux);
+}
+
+static void formatSnapshot()
+{
+    SensorRecord avg = getSensorBufferAverage();
+    TlsHandshakeStats tls = tlsGetHandshakeStats();
+    BurstCaptureStats burst = burstCaptureGetStats();
+
+    // Un client lent qui lit encore l'ancien buffer : on garde la version publiée jusqu'au prochain tour
+    char *snapshot = beginFormat(snapshotJson);
+    if (snapshot != NULL)
+    {
+        int length = snprintf(snapshot, snapshotJson.capacity,
+                              "{\"timestamp\":%lu,\"mq135_ppm\":%.2f,\"mq136_ppm\":%.2f,\"mq4_ppm\":%.2f,\"mic_db\":%.2f}",
+                              (unsigned long)avg.timestamp, avg.mq135_ppm, avg.mq136_ppm, avg.mq4_ppm, avg.mic_db);
+        publishFormat(snapshotJson, length);
+    }
+
+    char *metrics = beginFormat(metricsText);
+    if (metrics == NULL)
+        return;
+
+    int length = snprintf(metrics, metricsText.capacity,
+             "# TYPE proutometre_buffer_fill gauge\n"
+             "proutometre_buffer_fill %d\n"
+             "# TYPE proutometre_buffer_capacity gauge\n"
+             "proutometre_buffer_capacity %d\n"
+             "# TYPE proutometre_buffer_overwritten_total counter\n"
+             "proutometre_buffer_overwritten_total %lu\n"
+             "# TYPE proutometre_heap_free_bytes gauge\n"
+             "proutometre_heap_free_bytes %lu\n"
+             "# TYPE proutometre_heap_min_free_bytes gauge\n"
+             "proutometre_heap_min_free_bytes %lu\n"
+             "# TYPE proutometre_loop_time_us gauge\n"
+             "proutometre_loop_time_us %lu\n"
+             "# TYPE proutometre_loop_time_max_us gauge\n"
+             "proutometre_loop_time_max_us %lu\n"
+             "# TYPE proutometre_http_failures_total counter\n"
+             "proutometre_http_failures_total %lu\n"
+             "# TYPE proutometre_ingest_failovers_total counter\n"
+             "proutometre_ingest_failovers_total %lu\n"
+             "# TYPE proutometre_acoustic_cpu_percent gauge\n"
+             "proutometre_acoustic_cpu_percent %.1f\n"
+             "# TYPE proutometre_acoustic_late_samples_total counter\n"
+             "proutometre_acoustic_late_samples_total %lu\n"
+             "# TYPE proutometre_log_dropped_total counter\n"
+             "proutometre_log_dropped_total %lu\n"
+             "# TYPE proutometre_tls_handshakes_total counter\n"
+             "proutometre_tls_handshakes_total{type=\"full\"} %lu\n"
+             "proutometre_tls_handshakes_total{type=\"resumed\"} %lu\n"
+             "proutometre_tls_handshakes_total{type=\"failed\"} %lu\n"
+             "# TYPE proutometre_tls_handshake_us gauge\n"
+             "proutometre_tls_handshake_us{type=\"full\"} %lu\n"
+             "proutometre_tls_handshake_us{type=\"resumed\"} %lu\n"
+             "# TYPE proutometre_tls_handshake_peak_heap_bytes gauge\n"
+             "proutometre_tls_handshake_peak_heap_bytes{type=\"full\"} %lu\n"
+             "proutometre_tls_handshake_peak_heap_bytes{type=\"resumed\"} %lu\n"
+             "# TYPE proutometre_tls_sessions_uncached_total counter\n"
+             "proutometre_tls_sessions_uncached_total %lu\n"
+             "# TYPE proutometre_burst_captures_total counter\n"
+             "proutometre_burst_captures_total{state=\"recorded\"} %lu\n"
+             "proutometre_burst_captures_total{state=\"uploaded\"} %lu\n"
+             "proutometre_burst_captures_total{state=\"rejected\"} %lu\n"
+             "proutometre_burst_captures_total{state=\"dropped\"} %lu\n"
+             "# TYPE proutometre_burst_read_us gauge\n"
+             "proutometre_burst_read_us{stat=\"avg\"} %lu\n"
+             "proutometre_burst_read_us{stat=\"max\"} %lu\n"
+             "# TYPE proutometre_burst_jitter_max_us gauge\n"
+             "proutometre_burst_jitter_max_us %lu\n"
+             "# TYPE proutometre_burst_late_samples_total counter\n"
+             "proutometre_burst_late_samples_total %lu\n"
+             "# TYPE proutometre_sse_clients gauge\n"
+             "proutometre_sse_clients %u\n"
+             "# TYPE proutometre_uptime_seconds counter\n"
+             "proutometre_uptime_seconds %lu\n",
+             getSensorBufferSize(),
+             MAX_BUFFER_SIZE,
+             (unsigned long)getSensorBufferOverwrittenCount(),
+             (unsigned long)ESP.getFreeHeap(),
+             (unsigned long)ESP.getMinFreeHeap(),
+             (unsigned long)loopTimeUs,
+             (unsigned long)loopTimeMaxUs,
+             (unsigned long)heartbeatGetHttpFailureCount(),
+             (unsigned long)heartbeatGetFailoverCount(),
+             acousticManagerGetCpuLoad(),
+             (unsigned long)acousticManagerGetLateSampleCount(),
+             (unsigned long)logManagerGetDroppedCount(),
+             (unsigned long)tls.fullCount,
+             (unsigned long)tls.resumedCount,
+             (unsigned long)tls.failedCount,
+             (unsigned long)tls.lastFullUs,
+             (unsigned long)tls.lastResumedUs,
+             (unsigned long)tls.peakHeapFull,
+             (unsigned long)tls.peakHeapResumed,
+             (unsigned long)tls.sessionTooLarge,
+             (unsigned long)burst.recorded,
+             (unsigned long)burst.uploaded,
+             (unsigned long)burst.rejected,
+             (unsigned long)burst.dropped,
+             (unsigned long)burst.readAvgUs,
+             (unsigned long)burst.readMaxUs,
+             (unsigned long)burst.jitterMaxUs,
+             (unsigned long)burst.lateSamples,
+             (unsigned)events.count(),
+             millis() / 1000);
+
+    // Pile libre par tâche ayant fait un handshake complet : nombre de tâches variable, en fin
+    for (int i = 0; i < TLS_STACK_TASKS && tls.stackTask[i][0] != '\0'; i++)
+    {
+        if (length < 0 || (size_t)length >= metricsText.capacity)
+            break;
+        length += snprintf(metrics + length, metricsText.capacity - length,
+                           "%sproutometre_tls_stack_free_min_bytes{task=\"%s\"} %lu\n",
+                           i == 0 ? "# TYPE proutometre_tls_stack_free_min_bytes gauge\n" : "",
+                           tls.stackTask[i], (unsigned long)tls.stackFreeMin[i]);
+    }
+    publishFormat(metricsText, length);
+}
+
+static void releaseBuffer(PreformattedText &preformatted, int index)
+{
+    portENTER_CRITICAL(&snapshotMux);
+    preformatted.readers[index]--;
+    portEXIT_CRITICAL(&snapshotMux);
+}
+
+// Envoi direct depuis le buffer publié, épinglé jusqu'à la fin de la requête (tâche async_tcp)
+static void sendPreformatted(AsyncWebServerRequest *request, const char *contentType, PreformattedText &preformatted)
+{
+    portENTER_CRITICAL(&snapshotMux);
+    int index = preformatted.published;
+    preformatted.readers[index]++;
+    size_t length = preformatted.length[index];
+    portEXIT_CRITICAL(&snapshotMux);
+
+    const char *text = preformatted.text[index];
+    AsyncWebServerResponse *response = request->beginResponse(
+        contentType, length, [text, length](uint8_t *buffer, size_t maxLen, size_t offset) -> size_t
+        {
+            size_t chunk = min(maxLen, length - offset);
+            memcpy(buffer, text + offset, chunk);
+            return chunk; });
+    if (response == NULL)
+    {
+        releaseBuffer(preformatted, index);
+        request->send(503);
+        return;
+    }
+
+    // Appelé à la destruction de la requête, réponse envoyée ou client déconnecté
+    request->onDisconnect([&preformatted, index]()
+                          { releaseBuffer(preformatted, index); });
+    request->send(response);
+}
+
+// ======== FONCTIONS PUBLIQUES ========
+
+void localServerManagerInit()
+{
+    Serial.println("Local Server: Initialisation du serveur HTTP local...");
+
+    events.onConnect([](AsyncEventSourceClient *client)
+                     {
+        if (events.count() > LOCAL_SERVER_MAX_SSE_CLIENTS)
+        {
+            client->close();
+            return;
+        }
+        client->send("hello", NULL, millis(), 1000); });
+
+    server.on("/metrics", HTTP_GET, [](AsyncWebServerRequest *request)
+              { sendPreformatted(request, "text/plain; version=0.0.4", metricsText); });
+
+    server.on("/snapshot", HTTP_GET, [](AsyncWebServerRequest *request)
+              { sendPreformatted(request, "application/json", snapshotJson); });
+
+    server.addHandler(&events);
+    server.onNotFound([](AsyncWebServerRequest *request)
+                      { request->send(404); });
+
+    formatSnapshot();
+    server.begin();
+
+    Serial.printf("Local Server: Serveur démarré sur le port %d\n", LOCAL_SERVER_PORT);
+}
+
+void localServerManagerProcess()
+{
+    // Diffuser chaque nouvelle lecture aux clients SSE (send() ne fait que mettre en file)
+    SensorRecord reading;
+    uint32_t readingCount = getLastSensorReading(reading);
+    if (readingCount != lastReadingCount)
+    {
+        lastReadingCount = readingCount;
+        if (events.count() > 0)
+        {
+            snprintf(sampleEvent, sizeof(sampleEvent),
+                     "{\"timestamp\":%lu,\"mq135_ppm\":%.2f,\"mq136_ppm\":%.2f,\"mq4_ppm\":%.2f,\"mic_db\":%.2f}",
+                     (unsigned long)reading.timestamp, reading.mq135_ppm, reading.mq136_ppm, reading.mq4_ppm, reading.mic_db);
+            events.send(sampleEvent, "sample", readingCount);
+        }
+    }
+
+    if (millis() - lastSnapshotTime >= LOCAL_SERVER_SNAPSHOT_INTERVAL)
+    {
+        lastSnapshotTime = millis();
+        formatSnapshot();
+        loopTimeMaxUs = 0;
+    }
+}
+
+void localServerReportLoopTime(uint32_t loopTime)
+{
+    loopTimeUs = loopTime;
+    if (loopTime > loopTimeMaxUs)
+        loopTimeMaxUs = loopTime;
+}
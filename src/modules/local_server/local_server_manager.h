@@ -0,0 +1,19 @@
+#pragma once
+#include <Arduino.h>
+
+// ======== CONFIGURATION ========
+#define LOCAL_SERVER_PORT 80
+#define LOCAL_SERVER_MAX_SSE_CLIENTS 4     // clients SSE simultanés acceptés
+#define LOCAL_SERVER_SNAPSHOT_INTERVAL 1000 // rafraîchissement de /metrics et /snapshot (ms)
+
+// Serveur HTTP local (asynchrone) :
+//   GET /events   -> flux Server-Sent Events des lectures converties (rythme plein)
+//   GET /metrics  -> métriques au format texte Prometheus
+//   GET /snapshot -> moyenne du buffer capteurs en JSON
+// Les réponses sont préformatées dans la loop principale (double buffer statique) ;
+// les handlers les envoient telles quelles, sans copie.
+void localServerManagerInit();
+void localServerManagerProcess();
+
+// Durée de travail de la dernière itération de la loop (µs)
+void localServerReportLoopTime(uint32_t loopTime);
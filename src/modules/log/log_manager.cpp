@@ -0,0 +1,272 @@
+#include "log_manager.h"
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+static_assert((LOG_RING_SIZE & (LOG_RING_SIZE - 1)) == 0, "LOG_RING_SIZE doit être une puissance de 2");
+
+static LogEntry ring[LOG_RING_SIZE];
+static std::atomic<uint32_t> enqueuePosition(0);
+static std::atomic<uint32_t> dequeuePosition(0); // écrite par le seul consommateur (tâche de vidage)
+static std::atomic<uint32_t> droppedCount(0);
+static TaskHandle_t logTaskHandle = NULL;
+
+static const char LEVEL_LETTERS[] = {'D', 'I', 'W', 'E'};
+static const uint8_t FRAME_SYNC = 0xA5;
+
+// ======== RING SANS VERROU ========
+// Chaque case porte un numéro de séquence : égal à la position quand elle est libre,
+// position + 1 quand elle est publiée. Un producteur réserve sa case par CAS.
+
+LogEntry *logReserve()
+{
+    uint32_t position = enqueuePosition.load(std::memory_order_relaxed);
+    while (true)
+    {
+        LogEntry *entry = &ring[position & (LOG_RING_SIZE - 1)];
+        int32_t diff = (int32_t)(entry->sequence.load(std::memory_order_acquire) - position);
+
+        if (diff == 0)
+        {
+            if (enqueuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                return entry;
+        }
+        else if (diff < 0)
+        {
+            // Ring plein : on perd le message plutôt que d'attendre
+            droppedCount.fetch_add(1, std::memory_order_relaxed);
+            return NULL;
+        }
+        else
+        {
+            position = enqueuePosition.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+void logCommit(LogEntry *entry)
+{
+    uint32_t position = entry->sequence.load(std::memory_order_relaxed);
+    entry->sequence.store(position + 1, std::memory_order_release);
+}
+
+static LogEntry *logPeek()
+{
+    uint32_t position = dequeuePosition.load(std::memory_order_relaxed);
+    LogEntry *entry = &ring[position & (LOG_RING_SIZE - 1)];
+    if (entry->sequence.load(std::memory_order_acquire) != position + 1)
+        return NULL;
+    return entry;
+}
+
+static void logRelease(LogEntry *entry)
+{
+    uint32_t position = dequeuePosition.load(std::memory_order_relaxed);
+    entry->sequence.store(position + LOG_RING_SIZE, std::memory_order_release);
+    dequeuePosition.store(position + 1, std::memory_order_relaxed);
+}
+
+// ======== SORTIE TEXTE ========
+
+// Formater un argument selon sa spécification printf (sans modificateur de longueur)
+static int formatArgument(char *out, size_t outSize, const char *spec, size_t specLength, char conversion,
+                          const LogEntry &entry, uint8_t &argIndex)
+{
+    if (argIndex >= entry.argCount)
+        return snprintf(out, outSize, "<?>");
+
+    char fmt[24];
+    if (specLength > sizeof(fmt) - 4)
+        specLength = sizeof(fmt) - 4;
+    memcpy(fmt, spec, specLength);
+
+    uint8_t type = entry.types[argIndex];
+    uint32_t low = entry.args[argIndex++];
+    uint64_t raw = low;
+    if ((type == LOG_ARG_INT64 || type == LOG_ARG_UINT64) && argIndex < entry.argCount)
+        raw |= (uint64_t)entry.args[argIndex++] << 32;
+
+    switch (conversion)
+    {
+    case 'd':
+    case 'i':
+    {
+        long long value = type == LOG_ARG_INT32 ? (int32_t)low : (long long)raw;
+        memcpy(fmt + specLength, "lld", 4);
+        return snprintf(out, outSize, fmt, value);
+    }
+    case 'u':
+    case 'x':
+    case 'X':
+    case 'o':
+    {
+        unsigned long long value = type == LOG_ARG_INT32 ? (uint32_t)low : raw;
+        fmt[specLength] = 'l';
+        fmt[specLength + 1] = 'l';
+        fmt[specLength + 2] = conversion;
+        fmt[specLength + 3] = '\0';
+        return snprintf(out, outSize, fmt, value);
+    }
+    case 'c':
+        fmt[specLength] = 'c';
+        fmt[specLength + 1] = '\0';
+        return snprintf(out, outSize, fmt, (int)low);
+    case 's':
+        fmt[specLength] = 's';
+        fmt[specLength + 1] = '\0';
+        return snprintf(out, outSize, fmt, type == LOG_ARG_STRING && low < LOG_STRING_POOL_SIZE ? entry.strings + low : "<?>");
+    case 'p':
+        return snprintf(out, outSize, "0x%08lx", (unsigned long)low);
+    default:
+    {
+        // Flottants : f, F, e, E, g, G, a, A
+        float value;
+        memcpy(&value, &low, sizeof(value));
+        fmt[specLength] = conversion;
+        fmt[specLength + 1] = '\0';
+        return snprintf(out, outSize, fmt, type == LOG_ARG_FLOAT ? (double)value : (double)(int32_t)low);
+    }
+    }
+}
+
+static void writeText(const LogEntry &entry)
+{
+    char line[256];
+    size_t length = snprintf(line, sizeof(line), "%c %llu.%03lu ",
+                             LEVEL_LETTERS[entry.level & 3],
+                             (unsigned long long)(entry.timestamp / 1000000),
+                             (unsigned long)(entry.timestamp / 1000 % 1000));
+    uint8_t argIndex = 0;
+
+    for (const char *p = entry.format; *p && length < sizeof(line) - 1; p++)
+    {
+        if (*p != '%')
+        {
+            line[length++] = *p;
+            continue;
+        }
+        if (p[1] == '%')
+        {
+            line[length++] = '%';
+            p++;
+            continue;
+        }
+
+        // Spécification : drapeaux, largeur, précision, puis longueur (ignorée) et conversion
+        const char *spec = p++;
+        while (*p && strchr("-+ #0123456789.", *p))
+            p++;
+        size_t specLength = p - spec;
+        while (*p && strchr("hljztL", *p))
+            p++;
+        if (!*p)
+            break;
+
+        int written = formatArgument(line + length, sizeof(line) - length, spec, specLength, *p, entry, argIndex);
+        if (written > 0)
+            length = min(length + written, sizeof(line) - 1);
+    }
+
+    // Les formats hérités de Serial.printf se terminent déjà par \n
+    if (length == 0 || line[length - 1] != '\n')
+    {
+        if (length >= sizeof(line) - 1)
+            length = sizeof(line) - 2;
+        line[length++] = '\n';
+    }
+    Serial.write((const uint8_t *)line, length);
+}
+
+// ======== SORTIE BINAIRE ========
+// Trame : u8 0xA5 | u8 niveau | u8 nbArgs | u8 octetsChaînes | u64 timestamp | u32 adresseFormat
+//         | u8 types[nbArgs] | u32 args[nbArgs] | chaînes
+// Une adresse de format nulle signale des messages perdus (args[0] = nombre).
+
+static void writeBinary(const LogEntry &entry)
+{
+    uint8_t header[16] = {FRAME_SYNC, entry.level, entry.argCount, entry.stringsUsed};
+    uint32_t formatAddress = (uint32_t)(uintptr_t)entry.format;
+    memcpy(header + 4, &entry.timestamp, 8);
+    memcpy(header + 12, &formatAddress, 4);
+
+    Serial.write(header, sizeof(header));
+    Serial.write(entry.types, entry.argCount);
+    Serial.write((const uint8_t *)entry.args, entry.argCount * sizeof(uint32_t));
+    Serial.write((const uint8_t *)entry.strings, entry.stringsUsed);
+}
+
+static void writeDropped(uint32_t dropped)
+{
+    LogEntry entry;
+    entry.timestamp = esp_timer_get_time();
+    entry.format = LOG_OUTPUT_BINARY ? NULL : "Log: %u messages perdus";
+    entry.level = LOG_LEVEL_WARN;
+    entry.argCount = 0;
+    entry.stringsUsed = 0;
+    logPush(entry, LOG_ARG_UINT32, dropped);
+
+    if (LOG_OUTPUT_BINARY)
+        writeBinary(entry);
+    else
+        writeText(entry);
+}
+
+// ======== TÂCHE DE VIDAGE ========
+
+void logTask(void *parameter)
+{
+    uint32_t reportedDropped = 0;
+
+    while (true)
+    {
+        LogEntry *entry = logPeek();
+        if (entry == NULL)
+        {
+            uint32_t dropped = droppedCount.load(std::memory_order_relaxed);
+            if (dropped != reportedDropped)
+            {
+                writeDropped(dropped - reportedDropped);
+                reportedDropped = dropped;
+            }
+            vTaskDelay(pdMS_TO_TICKS(LOG_DRAIN_INTERVAL));
+            continue;
+        }
+
+        if (LOG_OUTPUT_BINARY)
+            writeBinary(*entry);
+        else
+            writeText(*entry);
+        logRelease(entry);
+    }
+}
+
+// ======== FONCTIONS PUBLIQUES ========
+
+void logManagerInit()
+{
+    for (uint32_t i = 0; i < LOG_RING_SIZE; i++)
+        ring[i].sequence.store(i, std::memory_order_relaxed);
+
+    // Priorité la plus basse au-dessus de l'idle, sur le core 0 (le core 1 fait l'acquisition)
+    BaseType_t result = xTaskCreatePinnedToCore(
+        logTask,
+        "LogTask",
+        3072,
+        NULL,
+        tskIDLE_PRIORITY + 1,
+        &logTaskHandle,
+        0);
+
+    if (result != pdPASS)
+        Serial.println("Log Manager: Erreur - Impossible de créer la tâche de log");
+}
+
+uint32_t logManagerGetDroppedCount()
+{
+    return droppedCount.load(std::memory_order_relaxed);
+}
+
+uint32_t logManagerGetFreeCount()
+{
+    uint32_t used = enqueuePosition.load(std::memory_order_relaxed) - dequeuePosition.load(std::memory_order_relaxed);
+    return used < LOG_RING_SIZE ? LOG_RING_SIZE - used : 0;
+}
@@ -0,0 +1,184 @@
+#pragma once
+#include <Arduino.h>
+#include <esp_timer.h>
+#include <atomic>
+#include <type_traits>
+
+// ======== NIVEAUX ========
+#define LOG_LEVEL_DEBUG 0
+#define LOG_LEVEL_INFO 1
+#define LOG_LEVEL_WARN 2
+#define LOG_LEVEL_ERROR 3
+#define LOG_LEVEL_NONE 4
+
+// ======== CONFIGURATION ========
+// Les appels sous LOG_LEVEL disparaissent à la compilation (surcharge via build_flags)
+#ifndef LOG_LEVEL
+#define LOG_LEVEL LOG_LEVEL_INFO
+#endif
+#define LOG_RING_SIZE 64         // Entrées du ring (puissance de 2)
+#define LOG_MAX_ARGS 8           // Arguments max par appel (un int64/uint64 en compte deux)
+#define LOG_STRING_POOL_SIZE 48  // Octets copiés pour les arguments %s (tronqués au-delà)
+#define LOG_OUTPUT_BINARY false  // true : trames binaires à décoder avec tools/log_decoder.py
+#define LOG_DRAIN_INTERVAL 10    // Attente de la tâche de vidage quand le ring est vide (ms)
+
+// Un appel LOG_* copie l'adresse du format (en flash) et les arguments bruts dans un ring
+// sans verrou ; le formatage et l'écriture sur le port série sont faits par une tâche basse
+// priorité. Si le ring est plein, le message est perdu (et compté), l'appelant n'attend jamais.
+// Sous LOG_LEVEL, l'appel reste compilé mais jamais exécuté : les arguments sont vérifiés et
+// comptent comme utilisés, le compilateur élimine le code mort.
+#define LOG_DISABLED(level, format, ...)            \
+    do                                              \
+    {                                               \
+        if (0)                                      \
+            logWrite(level, format, ##__VA_ARGS__); \
+    } while (0)
+
+#if LOG_LEVEL <= LOG_LEVEL_DEBUG
+#define LOG_DEBUG(format, ...) logWrite(LOG_LEVEL_DEBUG, format, ##__VA_ARGS__)
+#else
+#define LOG_DEBUG(format, ...) LOG_DISABLED(LOG_LEVEL_DEBUG, format, ##__VA_ARGS__)
+#endif
+
+#if LOG_LEVEL <= LOG_LEVEL_INFO
+#define LOG_INFO(format, ...) logWrite(LOG_LEVEL_INFO, format, ##__VA_ARGS__)
+#else
+#define LOG_INFO(format, ...) LOG_DISABLED(LOG_LEVEL_INFO, format, ##__VA_ARGS__)
+#endif
+
+#if LOG_LEVEL <= LOG_LEVEL_WARN
+#define LOG_WARN(format, ...) logWrite(LOG_LEVEL_WARN, format, ##__VA_ARGS__)
+#else
+#define LOG_WARN(format, ...) LOG_DISABLED(LOG_LEVEL_WARN, format, ##__VA_ARGS__)
+#endif
+
+#if LOG_LEVEL <= LOG_LEVEL_ERROR
+#define LOG_ERROR(format, ...) logWrite(LOG_LEVEL_ERROR, format, ##__VA_ARGS__)
+#else
+#define LOG_ERROR(format, ...) LOG_DISABLED(LOG_LEVEL_ERROR, format, ##__VA_ARGS__)
+#endif
+
+// ======== STRUCTURE ========
+enum LogArgType : uint8_t
+{
+    LOG_ARG_INT32 = 0,
+    LOG_ARG_UINT32 = 1,
+    LOG_ARG_INT64 = 2,  // occupe deux emplacements (poids faible puis fort)
+    LOG_ARG_UINT64 = 3, // idem
+    LOG_ARG_FLOAT = 4,  // flottants stockés en simple précision
+    LOG_ARG_STRING = 5, // valeur = offset dans le pool de chaînes
+    LOG_ARG_POINTER = 6,
+};
+
+struct LogEntry
+{
+    std::atomic<uint32_t> sequence; // protocole du ring (producteurs multiples, consommateur unique)
+    const char *format;             // sert d'identifiant de format (adresse en flash)
+    uint64_t timestamp;             // µs depuis le démarrage (64 bits : pas de rebouclage à 71 min)
+    uint8_t level;
+    uint8_t argCount;
+    uint8_t stringsUsed;
+    uint8_t types[LOG_MAX_ARGS];
+    uint32_t args[LOG_MAX_ARGS];
+    char strings[LOG_STRING_POOL_SIZE];
+};
+
+// ======== FONCTIONS PUBLIQUES ========
+void logManagerInit();
+
+// Nombre de messages perdus faute de place dans le ring
+uint32_t logManagerGetDroppedCount();
+
+// Entrées libres dans le ring (instantané) : un émetteur de gros volume s'y règle pour ne
+// pas faire perdre les messages des autres
+uint32_t logManagerGetFreeCount();
+
+// Réservation / publication d'une entrée (utilisées par logWrite)
+LogEntry *logReserve();
+void logCommit(LogEntry *entry);
+
+// ======== ENCODAGE DES ARGUMENTS ========
+inline void logPush(LogEntry &entry, uint8_t type, uint32_t value)
+{
+    if (entry.argCount < LOG_MAX_ARGS)
+    {
+        entry.types[entry.argCount] = type;
+        entry.args[entry.argCount] = value;
+        entry.argCount++;
+    }
+}
+
+inline void logEncodeString(LogEntry &entry, const char *value)
+{
+    uint8_t offset = entry.stringsUsed;
+    if (value == NULL)
+        value = "(null)";
+    while (*value && entry.stringsUsed < LOG_STRING_POOL_SIZE - 1)
+        entry.strings[entry.stringsUsed++] = *value++;
+    if (entry.stringsUsed < LOG_STRING_POOL_SIZE)
+        entry.strings[entry.stringsUsed++] = '\0';
+    logPush(entry, LOG_ARG_STRING, offset);
+}
+
+inline void logEncode(LogEntry &entry, const char *value) { logEncodeString(entry, value); }
+inline void logEncode(LogEntry &entry, char *value) { logEncodeString(entry, value); }
+inline void logEncode(LogEntry &entry, const String &value) { logEncodeString(entry, value.c_str()); }
+
+inline void logEncode(LogEntry &entry, float value)
+{
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    logPush(entry, LOG_ARG_FLOAT, bits);
+}
+
+inline void logEncode(LogEntry &entry, double value) { logEncode(entry, (float)value); }
+
+template <typename T>
+inline typename std::enable_if<std::is_integral<T>::value || std::is_enum<T>::value>::type
+logEncode(LogEntry &entry, T value)
+{
+    if (sizeof(T) > 4)
+    {
+        if (entry.argCount + 2 > LOG_MAX_ARGS)
+            return;
+        uint64_t raw = (uint64_t)value;
+        uint8_t type = std::is_signed<T>::value ? LOG_ARG_INT64 : LOG_ARG_UINT64;
+        logPush(entry, type, (uint32_t)raw);
+        logPush(entry, type, (uint32_t)(raw >> 32));
+    }
+    else
+    {
+        logPush(entry, std::is_signed<T>::value ? LOG_ARG_INT32 : LOG_ARG_UINT32, (uint32_t)value);
+    }
+}
+
+template <typename T>
+inline void logEncode(LogEntry &entry, T *value)
+{
+    logPush(entry, LOG_ARG_POINTER, (uint32_t)(uintptr_t)value);
+}
+
+inline void logEncodeAll(LogEntry &) {}
+
+template <typename First, typename... Rest>
+inline void logEncodeAll(LogEntry &entry, const First &first, const Rest &...rest)
+{
+    logEncode(entry, first);
+    logEncodeAll(entry, rest...);
+}
+
+template <typename... Args>
+inline void logWrite(uint8_t level, const char *format, const Args &...args)
+{
+    LogEntry *entry = logReserve();
+    if (entry == NULL)
+        return;
+
+    entry->timestamp = esp_timer_get_time();
+    entry->format = format;
+    entry->level = level;
+    entry->argCount = 0;
+    entry->stringsUsed = 0;
+    logEncodeAll(*entry, args...);
+    logCommit(entry);
+}
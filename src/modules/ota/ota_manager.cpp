@@ -3,6 +3,8 @@
 #include <Arduino.h>
 #include <WiFi.h>
 #include <modules/wifi/wifi_manager.h>
+#include <modules/trace/trace_manager.h>
+#include <modules/tls/tls_client.h>
 
 static char otaUrl[256] = "";
 static volatile bool otaRequested = false;
@@ -25,6 +27,8 @@ void otaManagerSetUrl(const char *url)
 
 void otaManagerHandle()
 {
+    TRACE_SCOPE("otaManagerHandle");
+
     if (otaRequested && !otaInProgress)
     {
         otaRequested = false;
@@ -39,8 +43,10 @@ void otaManagerHandle()
         Serial.print("Starting OTA from: ");
         Serial.println(otaUrl);
 
-        WiFiClient client;
-        t_httpUpdate_return ret = httpUpdate.update(client, otaUrl);
+        WiFiClient plainClient;
+        TlsClient tlsClient;
+        bool secure = strncmp(otaUrl, "https://", 8) == 0;
+        t_httpUpdate_return ret = httpUpdate.update(secure ? tlsClient : plainClient, otaUrl);
 
         switch (ret)
         {
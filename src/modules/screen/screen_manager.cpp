@@ -3,6 +3,7 @@
 #include <Adafruit_GFX.h>
 #include <Adafruit_SSD1306.h>
 #include "modules/wifi/wifi_manager.h"
+#include "modules/trace/trace_manager.h"
 
 #define SCREEN_WIDTH 128
 #define SCREEN_HEIGHT 64
@@ -29,6 +30,8 @@ void screenManagerInit()
 
 void screenManagerProcess()
 {
+    TRACE_SCOPE("screenManagerProcess");
+
     display.clearDisplay();
     display.setTextSize(2);
     display.setTextColor(SSD1306_WHITE);
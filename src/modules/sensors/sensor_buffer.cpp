@@ -1,4 +1,7 @@
 #include "sensor_buffer.h"
+#include <modules/acoustic/acoustic_manager.h>
+#include <modules/log/log_manager.h>
+#include <modules/trace/trace_manager.h>
 
 // ======== INSTANCE GLOBALE ========
 static SensorBuffer sensorBuffer;
@@ -15,14 +18,150 @@ void SensorBuffer::addSensorData(const SensorData &sensorData)
         max4466ToDecibels(sensorData.max4466Value));
 }
 
+// Seuils par canal, dans l'ordre des bits CHANNEL_*
+static const float CHANNEL_DEADBANDS[SENSOR_CHANNEL_COUNT] = {
+    MQ135_DEADBAND, MQ136_DEADBAND, MQ4_DEADBAND, MIC_DEADBAND};
+static const float CHANNEL_SLOPE_THRESHOLDS[SENSOR_CHANNEL_COUNT] = {
+    MQ135_SLOPE_THRESHOLD, MQ136_SLOPE_THRESHOLD, MQ4_SLOPE_THRESHOLD, MIC_SLOPE_THRESHOLD};
+
 void SensorBuffer::addSensorData(float mq135, float mq136, float mq4, float mic)
 {
+    uint32_t now = millis();
+    const float values[SENSOR_CHANNEL_COUNT] = {mq135, mq136, mq4, mic};
+
     SensorRecord record;
-    record.timestamp = millis();
+    record.timestamp = now;
     record.mq135_ppm = mq135;
     record.mq136_ppm = mq136;
     record.mq4_ppm = mq4;
     record.mic_db = mic;
+    record.channels = CHANNEL_ALL;
+
+    // Caractéristiques spectrales agrégées sur les 100 dernières ms
+    bool hasMicFeatures = acousticManagerGetFeatures(record.mic_features);
+    if (hasMicFeatures)
+        record.channels |= CHANNEL_MIC_FEATURES;
+
+    xSemaphoreTake(lock, portMAX_DELAY);
+    lastReading = record;
+    readingCount++;
+
+    if (ADAPTIVE_SAMPLING_ENABLED)
+    {
+        bool anySlopeExceeded = false;
+        record.channels = 0;
+        for (int c = 0; c < SENSOR_CHANNEL_COUNT; c++)
+        {
+            bool slopeExceeded = false;
+            if (updateChannel(c, values[c], now, slopeExceeded))
+                record.channels |= (1 << c);
+            anySlopeExceeded |= slopeExceeded;
+        }
+
+        // Un événement sur un canal ramène les autres au rythme plein
+        if (ADAPTIVE_SYNC_CHANNELS && anySlopeExceeded)
+        {
+            for (int c = 0; c < SENSOR_CHANNEL_COUNT; c++)
+                resetChannelRate(c);
+        }
+        uint8_t forced = (ADAPTIVE_SYNC_CHANNELS && anySlopeExceeded) ? CHANNEL_ALL : 0;
+
+        // Canaux dont la dernière valeur stockée a quitté le buffer (vidage, écrasement) :
+        // on les stocke à nouveau pour que le serveur puisse reconstruire à partir de cet envoi
+        forced |= anchorChannels;
+        anchorChannels = 0;
+
+        for (int c = 0; c < SENSOR_CHANNEL_COUNT; c++)
+        {
+            if ((forced & (1 << c)) && !(record.channels & (1 << c)))
+            {
+                record.channels |= (1 << c);
+                channelStates[c].lastStored = values[c];
+                channelStates[c].lastStoredTime = now;
+            }
+        }
+    }
+
+    if (hasMicFeatures && (record.channels & CHANNEL_MIC))
+        record.channels |= CHANNEL_MIC_FEATURES;
+
+    if (record.channels != 0)
+        pushRecord(record);
+
+    lastSampleTime = now;
+    xSemaphoreGive(lock);
+}
+
+bool SensorBuffer::updateChannel(int channel, float value, uint32_t now, bool &slopeExceeded)
+{
+    ChannelState &state = channelStates[channel];
+
+    if (!state.hasValue)
+    {
+        // Première lecture : toujours stockée, au rythme plein
+        state.hasValue = true;
+        state.lastRead = value;
+        state.lastReadTime = now;
+        state.lastStored = value;
+        state.lastStoredTime = now;
+        state.interval = SENSOR_SAMPLING_INTERVAL;
+        state.stableCount = 0;
+        return true;
+    }
+
+    // Pente depuis la lecture précédente (unité par seconde)
+    uint32_t dt = now - state.lastReadTime;
+    float slope = dt > 0 ? fabsf(value - state.lastRead) * 1000.0f / dt : 0.0f;
+    state.lastRead = value;
+    state.lastReadTime = now;
+
+    bool outsideDeadband = fabsf(value - state.lastStored) > CHANNEL_DEADBANDS[channel];
+    slopeExceeded = slope > CHANNEL_SLOPE_THRESHOLDS[channel];
+
+    if (slopeExceeded)
+    {
+        resetChannelRate(channel);
+    }
+    else if (outsideDeadband)
+    {
+        // Simple dérive : on stocke sans revenir au rythme plein
+        state.stableCount = 0;
+    }
+    else if (state.interval < ADAPTIVE_SLOW_INTERVAL && ++state.stableCount >= ADAPTIVE_STABLE_SAMPLES)
+    {
+        // Canal stable : on ralentit
+        state.interval = min<uint32_t>(state.interval * 2, ADAPTIVE_SLOW_INTERVAL);
+        state.stableCount = 0;
+    }
+
+    bool due = (now - state.lastStoredTime) >= state.interval;
+
+    // Sortie de bande morte : stockage immédiat, ce qui borne l'erreur de reconstruction.
+    // Au rythme lent, le canal reste stocké même inchangé (au plus ADAPTIVE_SLOW_INTERVAL
+    // sans valeur dans le buffer)
+    if (outsideDeadband || due)
+    {
+        state.lastStored = value;
+        state.lastStoredTime = now;
+        return true;
+    }
+    return false;
+}
+
+void SensorBuffer::resetChannelRate(int channel)
+{
+    channelStates[channel].interval = SENSOR_SAMPLING_INTERVAL;
+    channelStates[channel].stableCount = 0;
+}
+
+void SensorBuffer::pushRecord(const SensorRecord &record)
+{
+    storedCount++;
+    for (int c = 0; c < SENSOR_CHANNEL_COUNT; c++)
+    {
+        if (record.channels & (1 << c))
+            channelRecords[c]++;
+    }
 
     if (size < MAX_BUFFER_SIZE)
     {
@@ -33,27 +172,51 @@ void SensorBuffer::addSensorData(float mq135, float mq136, float mq4, float mic)
     else
     {
         // Buffer plein -> écrase le plus ancien élément
+        overwrittenCount++;
+        for (int c = 0; c < SENSOR_CHANNEL_COUNT; c++)
+        {
+            // Dernière valeur du canal écrasée : il sera stocké à la prochaine lecture
+            if ((buffer[startIndex].channels & (1 << c)) && --channelRecords[c] == 0)
+                anchorChannels |= (1 << c);
+        }
         buffer[startIndex] = record;
         startIndex = (startIndex + 1) % MAX_BUFFER_SIZE;
     }
-
-    lastSampleTime = millis();
 }
 
-void SensorBuffer::addToJson(JsonDocument &doc)
+int SensorBuffer::moveToJson(JsonDocument &doc)
 {
+    xSemaphoreTake(lock, portMAX_DELAY);
+    int records = size;
     JsonArray sensorsArray = doc.createNestedArray("sensors");
 
     for (int i = 0; i < size; i++)
     {
         int idx = (startIndex + i) % MAX_BUFFER_SIZE;
+        const SensorRecord &record = buffer[idx];
         JsonObject sensorJson = sensorsArray.createNestedObject();
-        sensorJson["timestamp"] = buffer[idx].timestamp;
-        sensorJson["mq135_ppm"] = buffer[idx].mq135_ppm;
-        sensorJson["mq136_ppm"] = buffer[idx].mq136_ppm;
-        sensorJson["mq4_ppm"] = buffer[idx].mq4_ppm;
-        sensorJson["mic_db"] = buffer[idx].mic_db;
+        sensorJson["timestamp"] = record.timestamp;
+        // Seuls les canaux stockés sont envoyés : un canal absent garde sa dernière valeur
+        if (record.channels & CHANNEL_MQ135)
+            sensorJson["mq135_ppm"] = record.mq135_ppm;
+        if (record.channels & CHANNEL_MQ136)
+            sensorJson["mq136_ppm"] = record.mq136_ppm;
+        if (record.channels & CHANNEL_MQ4)
+            sensorJson["mq4_ppm"] = record.mq4_ppm;
+        if (record.channels & CHANNEL_MIC)
+            sensorJson["mic_db"] = record.mic_db;
+        if (record.channels & CHANNEL_MIC_FEATURES)
+        {
+            sensorJson["mic_centroid_hz"] = record.mic_features.centroidHz;
+            sensorJson["mic_flatness"] = record.mic_features.flatness;
+            JsonArray bands = sensorJson.createNestedArray("mic_bands_db");
+            for (int b = 0; b < ACOUSTIC_BAND_COUNT; b++)
+                bands.add(record.mic_features.bandDb[b]);
+        }
     }
+    reset();
+    xSemaphoreGive(lock);
+    return records;
 }
 
 bool SensorBuffer::shouldSample()
@@ -71,33 +234,90 @@ void SensorBuffer::sampleIfNeeded()
 }
 
 void SensorBuffer::clear()
+{
+    xSemaphoreTake(lock, portMAX_DELAY);
+    reset();
+    xSemaphoreGive(lock);
+}
+
+uint32_t SensorBuffer::getLastReading(SensorRecord &record) const
+{
+    xSemaphoreTake(lock, portMAX_DELAY);
+    record = lastReading;
+    uint32_t count = readingCount;
+    xSemaphoreGive(lock);
+    return count;
+}
+
+void SensorBuffer::reset()
 {
     size = 0;
     startIndex = 0;
+    memset(channelRecords, 0, sizeof(channelRecords));
+    anchorChannels = CHANNEL_ALL;
 }
 
 SensorRecord SensorBuffer::getAverage() const
 {
+    SensorRecord avg = {};
+
+    xSemaphoreTake(lock, portMAX_DELAY);
     if (size == 0)
     {
-        return {0, 0.0, 0.0, 0.0, 0.0};
+        xSemaphoreGive(lock);
+        return avg;
     }
 
-    SensorRecord avg = {0, 0.0, 0.0, 0.0, 0.0};
+    // Moyenne par canal, sur les seuls enregistrements où il est présent
+    int counts[SENSOR_CHANNEL_COUNT] = {0, 0, 0, 0};
 
     for (int i = 0; i < size; i++)
     {
         int idx = (startIndex + i) % MAX_BUFFER_SIZE;
-        avg.mq135_ppm += buffer[idx].mq135_ppm;
-        avg.mq136_ppm += buffer[idx].mq136_ppm;
-        avg.mq4_ppm += buffer[idx].mq4_ppm;
-        avg.mic_db += buffer[idx].mic_db;
+        const SensorRecord &record = buffer[idx];
+        if (record.channels & CHANNEL_MQ135)
+        {
+            avg.mq135_ppm += record.mq135_ppm;
+            counts[0]++;
+        }
+        if (record.channels & CHANNEL_MQ136)
+        {
+            avg.mq136_ppm += record.mq136_ppm;
+            counts[1]++;
+        }
+        if (record.channels & CHANNEL_MQ4)
+        {
+            avg.mq4_ppm += record.mq4_ppm;
+            counts[2]++;
+        }
+        if (record.channels & CHANNEL_MIC)
+        {
+            avg.mic_db += record.mic_db;
+            counts[3]++;
+        }
     }
+    xSemaphoreGive(lock);
 
-    avg.mq135_ppm /= size;
-    avg.mq136_ppm /= size;
-    avg.mq4_ppm /= size;
-    avg.mic_db /= size;
+    if (counts[0] > 0)
+    {
+        avg.mq135_ppm /= counts[0];
+        avg.channels |= CHANNEL_MQ135;
+    }
+    if (counts[1] > 0)
+    {
+        avg.mq136_ppm /= counts[1];
+        avg.channels |= CHANNEL_MQ136;
+    }
+    if (counts[2] > 0)
+    {
+        avg.mq4_ppm /= counts[2];
+        avg.channels |= CHANNEL_MQ4;
+    }
+    if (counts[3] > 0)
+    {
+        avg.mic_db /= counts[3];
+        avg.channels |= CHANNEL_MIC;
+    }
     avg.timestamp = millis();
 
     return avg;
@@ -111,10 +331,13 @@ void sensorBufferInit()
     sensorBuffer.clear();
     Serial.printf("Sensor Buffer: Buffer initialisé avec une taille maximale de %d éléments\n", MAX_BUFFER_SIZE);
     Serial.printf("Sensor Buffer: Intervalle d'échantillonnage: %d ms\n", SENSOR_SAMPLING_INTERVAL);
+    if (ADAPTIVE_SAMPLING_ENABLED)
+        Serial.printf("Sensor Buffer: Échantillonnage adaptatif actif (intervalle lent: %d ms)\n", ADAPTIVE_SLOW_INTERVAL);
 }
 
 void sensorBufferProcess()
 {
+    TRACE_SCOPE("sensorBufferProcess");
     sensorBuffer.sampleIfNeeded();
 }
 
@@ -126,18 +349,38 @@ void addCurrentSensorDataToBuffer()
     sensorBuffer.addSensorData(currentData);
 }
 
-void getSensorBufferJson(JsonDocument &doc)
+int moveSensorBufferToJson(JsonDocument &doc)
 {
-    sensorBuffer.addToJson(doc);
+    return sensorBuffer.moveToJson(doc);
 }
 
 void clearSensorBuffer()
 {
-    Serial.printf("Sensor Buffer: Vidage du buffer (%d éléments supprimés)\n", sensorBuffer.getSize());
+    LOG_DEBUG("Sensor Buffer: Vidage du buffer (%d éléments supprimés)\n", sensorBuffer.getSize());
     sensorBuffer.clear();
 }
 
 int getSensorBufferSize()
 {
     return sensorBuffer.getSize();
-}
\ No newline at end of file
+}
+
+SensorRecord getSensorBufferAverage()
+{
+    return sensorBuffer.getAverage();
+}
+
+uint32_t getLastSensorReading(SensorRecord &record)
+{
+    return sensorBuffer.getLastReading(record);
+}
+
+uint32_t getSensorBufferOverwrittenCount()
+{
+    return sensorBuffer.getOverwrittenCount();
+}
+
+SensorBuffer &getSensorBuffer()
+{
+    return sensorBuffer;
+}
@@ -1,12 +1,47 @@
 #pragma once
 #include <Arduino.h>
 #include <ArduinoJson.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
 #include <modules/sensors/sensors_manager.h>
+#include <modules/acoustic/acoustic_dsp.h>
 
 // ======== CONFIGURATION ========
 #define MAX_BUFFER_SIZE 100
 #define SENSOR_SAMPLING_INTERVAL 100 // Intervalle d'échantillonnage en ms
 
+// ======== ÉCHANTILLONNAGE ADAPTATIF ========
+// Chaque canal est toujours lu toutes les SENSOR_SAMPLING_INTERVAL ms, mais n'est stocké
+// que s'il sort de sa bande morte ou si son intervalle courant est écoulé.
+// Un canal stable voit son intervalle doubler jusqu'à ADAPTIVE_SLOW_INTERVAL, auquel il
+// reste stocké même inchangé. Après un vidage ou un écrasement, la lecture suivante
+// stocke à nouveau les canaux concernés : chaque envoi est reconstructible seul, et
+// l'erreur de reconstruction (maintien de la dernière valeur) reste <= bande morte
+// (vérifié par test/test_sensor_buffer sur une trace rejouée).
+#define ADAPTIVE_SAMPLING_ENABLED true
+#define ADAPTIVE_SLOW_INTERVAL 6400    // Intervalle de stockage le plus lent (ms)
+#define ADAPTIVE_STABLE_SAMPLES 10     // Lectures stables avant de doubler l'intervalle
+#define ADAPTIVE_SYNC_CHANNELS true    // Un canal qui dépasse son seuil de pente ramène tous les canaux au rythme plein
+
+// Bande morte (unité du canal) et seuil de pente (unité du canal par seconde)
+#define MQ135_DEADBAND 2.0f
+#define MQ135_SLOPE_THRESHOLD 20.0f
+#define MQ136_DEADBAND 0.5f
+#define MQ136_SLOPE_THRESHOLD 5.0f
+#define MQ4_DEADBAND 10.0f
+#define MQ4_SLOPE_THRESHOLD 100.0f
+#define MIC_DEADBAND 1.5f
+#define MIC_SLOPE_THRESHOLD 30.0f
+
+// ======== CANAUX ========
+#define SENSOR_CHANNEL_COUNT 4
+#define CHANNEL_MQ135 (1 << 0)
+#define CHANNEL_MQ136 (1 << 1)
+#define CHANNEL_MQ4 (1 << 2)
+#define CHANNEL_MIC (1 << 3)
+#define CHANNEL_ALL (CHANNEL_MQ135 | CHANNEL_MQ136 | CHANNEL_MQ4 | CHANNEL_MIC)
+#define CHANNEL_MIC_FEATURES (1 << 4) // caractéristiques spectrales, stockées avec le canal micro
+
 // ======== STRUCTURE ========
 struct SensorRecord
 {
@@ -15,26 +50,70 @@ struct SensorRecord
     float mq136_ppm;
     float mq4_ppm;
     float mic_db;
+    AcousticFeatures mic_features;
+    uint8_t channels; // canaux présents dans cet enregistrement (CHANNEL_*)
+};
+
+// État de l'échantillonnage adaptatif d'un canal
+struct ChannelState
+{
+    float lastStored;        // dernière valeur stockée dans le buffer
+    float lastRead;          // dernière valeur lue
+    uint32_t lastStoredTime; // date du dernier stockage (ms)
+    uint32_t lastReadTime;   // date de la dernière lecture (ms)
+    uint32_t interval;       // intervalle de stockage courant (ms)
+    uint8_t stableCount;     // lectures stables consécutives
+    bool hasValue;           // au moins une valeur stockée
 };
 
 // ======== BUFFER ========
+// Alimenté par la boucle (cœur 1), lu et vidé par la tâche heartbeat (cœur 0) et lu par le
+// serveur local : les accès publics prennent le mutex. Un mutex plutôt qu'un portMUX, car la
+// construction du JSON alloue et dure trop longtemps pour masquer les interruptions.
 class SensorBuffer
 {
 private:
+    StaticSemaphore_t lockStorage;
+    SemaphoreHandle_t lock;
+
     SensorRecord buffer[MAX_BUFFER_SIZE];
     int size = 0;                // nombre d'éléments actuels
     int startIndex = 0;          // index du plus ancien élément
     uint32_t lastSampleTime = 0; // dernière fois qu'un échantillon a été pris
+    ChannelState channelStates[SENSOR_CHANNEL_COUNT] = {};
+    SensorRecord lastReading = {};  // dernière lecture, stockée ou non
+    uint32_t readingCount = 0;      // nombre total de lectures
+    uint32_t storedCount = 0;       // enregistrements stockés depuis le démarrage
+    uint32_t overwrittenCount = 0;  // enregistrements écrasés avant d'avoir été envoyés
+    uint8_t channelRecords[SENSOR_CHANNEL_COUNT] = {}; // enregistrements du buffer contenant chaque canal
+    uint8_t anchorChannels = 0;     // canaux à stocker à la prochaine lecture (CHANNEL_*)
+
+    // Décider si un canal doit être stocké, et mettre à jour son rythme
+    bool updateChannel(int channel, float value, uint32_t now, bool &slopeExceeded);
+
+    // Ramener un canal au rythme plein
+    void resetChannelRate(int channel);
+
+    // Stocker un enregistrement dans le buffer circulaire
+    void pushRecord(const SensorRecord &record);
+
+    // Vider le buffer (verrou déjà pris)
+    void reset();
 
 public:
+    SensorBuffer() { lock = xSemaphoreCreateMutexStatic(&lockStorage); }
+    SensorBuffer(const SensorBuffer &) = delete;
+    SensorBuffer &operator=(const SensorBuffer &) = delete;
+
     // Ajouter une nouvelle lecture avec conversion automatique
     void addSensorData(const SensorData &sensorData);
 
     // Ajouter une nouvelle lecture avec valeurs déjà converties
     void addSensorData(float mq135, float mq136, float mq4, float mic);
 
-    // Ajouter les données au JSON
-    void addToJson(JsonDocument &doc);
+    // Ajouter les données au JSON puis vider le buffer, sous le même verrou (aucun
+    // enregistrement stocké entre les deux n'est perdu). Retourne le nombre d'enregistrements
+    int moveToJson(JsonDocument &doc);
 
     // Vérifier si il faut prendre un nouvel échantillon
     bool shouldSample();
@@ -45,6 +124,17 @@ public:
     // Obtenir le nombre d'éléments dans le buffer
     int getSize() const { return size; }
 
+    // Obtenir un enregistrement (0 = le plus ancien), sans verrou : depuis la tâche qui alimente le buffer
+    const SensorRecord &getRecord(int index) const { return buffer[(startIndex + index) % MAX_BUFFER_SIZE]; }
+
+    // Copier la dernière lecture (au rythme plein, même si elle n'a pas été stockée) ;
+    // retourne le nombre total de lectures
+    uint32_t getLastReading(SensorRecord &record) const;
+
+    // Compteurs cumulés (pertes par débordement du buffer)
+    uint32_t getStoredCount() const { return storedCount; }
+    uint32_t getOverwrittenCount() const { return overwrittenCount; }
+
     // Vider le buffer après envoi
     void clear();
 
@@ -58,6 +148,10 @@ void sensorBufferProcess();
 
 // ======== FONCTIONS D'ACCÈS ========
 void addCurrentSensorDataToBuffer();
-void getSensorBufferJson(JsonDocument &doc);
+int moveSensorBufferToJson(JsonDocument &doc);
 void clearSensorBuffer();
-int getSensorBufferSize();
\ No newline at end of file
+int getSensorBufferSize();
+SensorRecord getSensorBufferAverage();
+uint32_t getLastSensorReading(SensorRecord &record);
+uint32_t getSensorBufferOverwrittenCount();
+SensorBuffer &getSensorBuffer();
@@ -1,10 +1,10 @@
 #include "sensors_manager.h"
 #include "../../config/pins_config.h"
+#include "../log/log_manager.h"
 
 // ----------------------------
 // CONFIGURATION
 // ----------------------------
-#define DEBUG true
 static unsigned long lastReadTime = 0;
 static const unsigned long READ_INTERVAL = 100; // ms
 
@@ -106,6 +106,8 @@ void sensorsManagerProcess()
     {
         lastReadTime = currentTime;
 
+#if LOG_LEVEL <= LOG_LEVEL_DEBUG
+        // Lectures et conversions (pow) qui ne servent qu'au log de debug
         uint16_t mq135Value = analogRead(MQ135_PIN);
         uint16_t mq136Value = analogRead(MQ136_PIN);
         uint16_t mq4Value = analogRead(MQ4_PIN);
@@ -116,26 +118,9 @@ void sensorsManagerProcess()
         float mq4PPM = mq4ToPPM(mq4Value);
         float max4466DB = max4466ToDecibels(max4466Value);
 
-        if (DEBUG)
-        {
-            Serial.print("[MQ135] ADC=");
-            Serial.print(mq135Value);
-            Serial.print(" -> PPM=");
-            Serial.println(mq135PPM, 2);
-            Serial.print("[MQ136] ADC=");
-            Serial.print(mq136Value);
-            Serial.print(" -> PPM=");
-            Serial.println(mq136PPM, 2);
-            Serial.print("[MQ4]   ADC=");
-            Serial.print(mq4Value);
-            Serial.print(" -> PPM=");
-            Serial.println(mq4PPM, 2);
-            Serial.print("[MAX4466] ADC=");
-            Serial.print(max4466Value);
-            Serial.print(" -> dB=");
-            Serial.println(max4466DB, 2);
-            Serial.println("------------------------------------------------");
-        }
+        LOG_DEBUG("[MQ135] ADC=%u -> PPM=%.2f | [MQ136] ADC=%u -> PPM=%.2f\n", mq135Value, mq135PPM, mq136Value, mq136PPM);
+        LOG_DEBUG("[MQ4] ADC=%u -> PPM=%.2f | [MAX4466] ADC=%u -> dB=%.2f\n", mq4Value, mq4PPM, max4466Value, max4466DB);
+#endif
     }
 }
 
@@ -0,0 +1,637 @@
+#include "tls_client.h"
+#include <Preferences.h>
+#include <esp_attr.h>
+#include <esp_timer.h>
+#include <esp_heap_caps.h>
+#include <mbedtls/net_sockets.h>
+#include <mbedtls/platform.h>
+#include <config/config.h>
+#include <modules/log/log_manager.h>
+
+// Suites ECDSA uniquement : pas de RSA côté serveur, signature et échange de clés sur P-256
+static const int CIPHERSUITES[] = {
+    MBEDTLS_TLS_ECDHE_ECDSA_WITH_AES_128_GCM_SHA256,
+    MBEDTLS_TLS_ECDHE_ECDSA_WITH_AES_128_CBC_SHA256,
+    0};
+static const mbedtls_ecp_group_id CURVES[] = {
+    MBEDTLS_ECP_DP_SECP256R1,
+    MBEDTLS_ECP_DP_NONE};
+
+static const uint32_t SESSION_CACHE_MAGIC = 0x544C5331; // "TLS1"
+
+// ======== CACHE DE SESSIONS ========
+// Copie en RTC (conservée au redémarrage logiciel / deep sleep), recopiée en NVS
+// après chaque handshake complet pour survivre à une coupure d'alimentation.
+
+struct TlsSessionSlot
+{
+    uint32_t magic;
+    uint16_t length;
+    char host[48];
+    uint8_t data[TLS_SESSION_MAX_SIZE];
+};
+
+static RTC_NOINIT_ATTR TlsSessionSlot sessionCache[TLS_SESSION_CACHE_SLOTS];
+static portMUX_TYPE cacheMux = portMUX_INITIALIZER_UNLOCKED;
+static portMUX_TYPE statsMux = portMUX_INITIALIZER_UNLOCKED;
+static TlsHandshakeStats stats = {};
+
+// ======== MESURE DU HEAP ========
+// Les allocations de mbedTLS passent par un compteur : le pic d'un handshake est mesuré
+// exactement, indépendamment des autres tâches. Même allocateur que celui d'ESP-IDF
+// (RAM interne) : les blocs alloués avant l'installation restent libérables.
+// Deux handshakes simultanés (heartbeat et modèle) se cumulent dans le pic.
+#if defined(MBEDTLS_PLATFORM_MEMORY) && !defined(MBEDTLS_PLATFORM_CALLOC_MACRO)
+#define TLS_COUNT_ALLOCATIONS 1
+#else
+#define TLS_COUNT_ALLOCATIONS 0 // allocateur figé à la compilation : heap libre échantillonné
+#endif
+
+static portMUX_TYPE heapMux = portMUX_INITIALIZER_UNLOCKED;
+static int32_t mbedtlsHeapInUse = 0;
+static int32_t mbedtlsHeapPeak = 0;
+
+#if TLS_COUNT_ALLOCATIONS
+static void *countingCalloc(size_t count, size_t size)
+{
+    void *block = heap_caps_calloc(count, size, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    if (block != NULL)
+    {
+        int32_t allocated = heap_caps_get_allocated_size(block);
+        portENTER_CRITICAL(&heapMux);
+        mbedtlsHeapInUse += allocated;
+        mbedtlsHeapPeak = max(mbedtlsHeapPeak, mbedtlsHeapInUse);
+        portEXIT_CRITICAL(&heapMux);
+    }
+    return block;
+}
+
+static void countingFree(void *block)
+{
+    if (block == NULL)
+        return;
+    int32_t allocated = heap_caps_get_allocated_size(block);
+    portENTER_CRITICAL(&heapMux);
+    mbedtlsHeapInUse -= allocated;
+    portEXIT_CRITICAL(&heapMux);
+    heap_caps_free(block);
+}
+#endif
+
+// Début de mesure : retourne l'occupation courante, qui sert de référence
+static int32_t heapMeasureStart()
+{
+#if TLS_COUNT_ALLOCATIONS
+    portENTER_CRITICAL(&heapMux);
+    mbedtlsHeapPeak = mbedtlsHeapInUse;
+    int32_t baseline = mbedtlsHeapInUse;
+    portEXIT_CRITICAL(&heapMux);
+    return baseline;
+#else
+    // Occupation approchée par l'opposé du heap libre
+    mbedtlsHeapPeak = -(int32_t)heap_caps_get_free_size(MALLOC_CAP_8BIT);
+    return mbedtlsHeapPeak;
+#endif
+}
+
+// Sans compteur : heap libre relevé à chaque retour de mbedtls_ssl_handshake()
+static void heapMeasureSample()
+{
+#if !TLS_COUNT_ALLOCATIONS
+    mbedtlsHeapPeak = max(mbedtlsHeapPeak, -(int32_t)heap_caps_get_free_size(MALLOC_CAP_8BIT));
+#endif
+}
+
+static uint32_t heapMeasurePeak(int32_t baseline)
+{
+    portENTER_CRITICAL(&heapMux);
+    int32_t peak = mbedtlsHeapPeak;
+    portEXIT_CRITICAL(&heapMux);
+    return peak > baseline ? peak - baseline : 0;
+}
+
+static bool slotValid(const TlsSessionSlot &slot)
+{
+    return slot.magic == SESSION_CACHE_MAGIC && slot.length > 0 && slot.length <= TLS_SESSION_MAX_SIZE;
+}
+
+static int findSlot(const char *host)
+{
+    for (int i = 0; i < TLS_SESSION_CACHE_SLOTS; i++)
+    {
+        if (slotValid(sessionCache[i]) && strncmp(sessionCache[i].host, host, sizeof(sessionCache[i].host)) == 0)
+            return i;
+    }
+    return -1;
+}
+
+static void persistSlot(int index)
+{
+    Preferences preferences;
+    char key[8];
+    snprintf(key, sizeof(key), "slot%d", index);
+    preferences.begin("tls", false);
+    preferences.putBytes(key, &sessionCache[index], sizeof(TlsSessionSlot));
+    preferences.end();
+}
+
+// Sérialiser la session courante dans le cache
+static void storeSession(mbedtls_ssl_context &ssl, const char *host, bool persist)
+{
+    mbedtls_ssl_session session;
+    mbedtls_ssl_session_init(&session);
+    if (mbedtls_ssl_get_session(&ssl, &session) != 0)
+    {
+        mbedtls_ssl_session_free(&session);
+        return;
+    }
+
+    // Taille requise d'abord : le certificat du serveur est conservé dans la session
+    size_t length = 0;
+    int ret = mbedtls_ssl_session_save(&session, NULL, 0, &length);
+    if (ret == MBEDTLS_ERR_SSL_BUFFER_TOO_SMALL && length > TLS_SESSION_MAX_SIZE)
+    {
+        mbedtls_ssl_session_free(&session);
+        LOG_WARN("TLS: Session de %s trop grande pour le cache (%u > %u octets), pas de reprise\n",
+                 host, (unsigned)length, (unsigned)TLS_SESSION_MAX_SIZE);
+        portENTER_CRITICAL(&statsMux);
+        stats.sessionTooLarge++;
+        portEXIT_CRITICAL(&statsMux);
+        return;
+    }
+
+    uint8_t *buffer = NULL;
+    if (ret == MBEDTLS_ERR_SSL_BUFFER_TOO_SMALL)
+    {
+        buffer = (uint8_t *)malloc(length);
+        ret = buffer ? mbedtls_ssl_session_save(&session, buffer, length, &length) : MBEDTLS_ERR_SSL_ALLOC_FAILED;
+    }
+    mbedtls_ssl_session_free(&session);
+    if (buffer == NULL || ret != 0)
+    {
+        LOG_WARN("TLS: Session de %s non sauvegardable (-0x%04x)\n", host, -ret);
+        free(buffer);
+        return;
+    }
+
+    int index = findSlot(host);
+    if (index < 0)
+    {
+        // Slot libre, sinon on remplace le premier
+        index = 0;
+        for (int i = 0; i < TLS_SESSION_CACHE_SLOTS; i++)
+        {
+            if (!slotValid(sessionCache[i]))
+            {
+                index = i;
+                break;
+            }
+        }
+    }
+
+    portENTER_CRITICAL(&cacheMux);
+    TlsSessionSlot &slot = sessionCache[index];
+    slot.magic = SESSION_CACHE_MAGIC;
+    slot.length = length;
+    strncpy(slot.host, host, sizeof(slot.host) - 1);
+    slot.host[sizeof(slot.host) - 1] = '\0';
+    memcpy(slot.data, buffer, length);
+    portEXIT_CRITICAL(&cacheMux);
+    free(buffer);
+
+    if (persist)
+        persistSlot(index);
+}
+
+// Charger la session en cache pour cet hôte ; false si aucune
+static bool loadSession(mbedtls_ssl_context &ssl, const char *host)
+{
+    uint8_t *buffer = (uint8_t *)malloc(TLS_SESSION_MAX_SIZE);
+    size_t length = 0;
+    if (buffer == NULL)
+        return false;
+
+    portENTER_CRITICAL(&cacheMux);
+    int index = findSlot(host);
+    if (index >= 0)
+    {
+        length = sessionCache[index].length;
+        memcpy(buffer, sessionCache[index].data, length);
+    }
+    portEXIT_CRITICAL(&cacheMux);
+
+    if (index < 0)
+    {
+        free(buffer);
+        return false;
+    }
+
+    mbedtls_ssl_session session;
+    mbedtls_ssl_session_init(&session);
+    bool loaded = mbedtls_ssl_session_load(&session, buffer, length) == 0 &&
+                  mbedtls_ssl_set_session(&ssl, &session) == 0;
+    mbedtls_ssl_session_free(&session);
+    free(buffer);
+    return loaded;
+}
+
+void tlsSessionCacheInit()
+{
+#if TLS_COUNT_ALLOCATIONS
+    mbedtls_platform_set_calloc_free(countingCalloc, countingFree);
+#endif
+
+    Preferences preferences;
+    preferences.begin("tls", true);
+    for (int i = 0; i < TLS_SESSION_CACHE_SLOTS; i++)
+    {
+        if (slotValid(sessionCache[i]))
+            continue;
+
+        char key[8];
+        snprintf(key, sizeof(key), "slot%d", i);
+        if (preferences.getBytes(key, &sessionCache[i], sizeof(TlsSessionSlot)) != sizeof(TlsSessionSlot) ||
+            !slotValid(sessionCache[i]))
+        {
+            sessionCache[i].magic = 0;
+        }
+    }
+    preferences.end();
+}
+
+TlsHandshakeStats tlsGetHandshakeStats()
+{
+    portENTER_CRITICAL(&statsMux);
+    TlsHandshakeStats copy = stats;
+    portEXIT_CRITICAL(&statsMux);
+    return copy;
+}
+
+// ======== TRANSPORT ========
+
+static int sendCallback(void *context, const unsigned char *buf, size_t len)
+{
+    WiFiClient *tcp = (WiFiClient *)context;
+    if (!tcp->connected())
+        return MBEDTLS_ERR_NET_CONN_RESET;
+    size_t written = tcp->write(buf, len);
+    return written > 0 ? (int)written : MBEDTLS_ERR_SSL_WANT_WRITE;
+}
+
+static int recvCallback(void *context, unsigned char *buf, size_t len)
+{
+    WiFiClient *tcp = (WiFiClient *)context;
+    int available = tcp->available();
+    if (available <= 0)
+        return tcp->connected() ? MBEDTLS_ERR_SSL_WANT_READ : MBEDTLS_ERR_NET_CONN_RESET;
+    int received = tcp->read(buf, min((size_t)available, len));
+    return received > 0 ? received : MBEDTLS_ERR_SSL_WANT_READ;
+}
+
+// ======== PILE ========
+// Relevé après un handshake complet, le plus profond (vérification ECDSA de la chaîne,
+// ECDHE) : minimum par tâche, l'entrée d'une tâche inconnue prend la première libre
+static void recordStackFree(uint32_t freeBytes)
+{
+    const char *task = pcTaskGetName(NULL);
+    portENTER_CRITICAL(&statsMux);
+    for (int i = 0; i < TLS_STACK_TASKS; i++)
+    {
+        if (stats.stackTask[i][0] == '\0')
+        {
+            strncpy(stats.stackTask[i], task, sizeof(stats.stackTask[i]) - 1);
+            stats.stackFreeMin[i] = freeBytes;
+            break;
+        }
+        if (strncmp(stats.stackTask[i], task, sizeof(stats.stackTask[i]) - 1) == 0)
+        {
+            stats.stackFreeMin[i] = min(stats.stackFreeMin[i], freeBytes);
+            break;
+        }
+    }
+    portEXIT_CRITICAL(&statsMux);
+}
+
+// ======== CLIENT ========
+
+struct TlsContexts
+{
+    mbedtls_ssl_context ssl;
+    mbedtls_ssl_config conf;
+    mbedtls_x509_crt ca;
+    mbedtls_entropy_context entropy;
+    mbedtls_ctr_drbg_context drbg;
+};
+
+TlsClient::TlsClient()
+{
+}
+
+TlsClient::~TlsClient()
+{
+    stop();
+}
+
+// Contextes et configuration de la connexion, libérés par stop()
+bool TlsClient::setupConfig()
+{
+    if (TLS_ROOT_CA == NULL || TLS_ROOT_CA[0] == '\0')
+    {
+        LOG_ERROR("TLS: Aucun certificat racine configuré (TLS_ROOT_CA)\n");
+        return false;
+    }
+
+    tls = (TlsContexts *)malloc(sizeof(TlsContexts));
+    if (tls == NULL)
+    {
+        LOG_ERROR("TLS: Mémoire insuffisante pour les contextes (%u octets)\n", (unsigned)sizeof(TlsContexts));
+        return false;
+    }
+    mbedtls_ssl_context &ssl = tls->ssl;
+    mbedtls_ssl_config &conf = tls->conf;
+    mbedtls_x509_crt &ca = tls->ca;
+    mbedtls_entropy_context &entropy = tls->entropy;
+    mbedtls_ctr_drbg_context &drbg = tls->drbg;
+    mbedtls_ssl_init(&ssl);
+    mbedtls_ssl_config_init(&conf);
+    mbedtls_x509_crt_init(&ca);
+    mbedtls_entropy_init(&entropy);
+    mbedtls_ctr_drbg_init(&drbg);
+
+    const char *personalization = "ProutOMetre";
+    int ret = mbedtls_ctr_drbg_seed(&drbg, mbedtls_entropy_func, &entropy,
+                                    (const unsigned char *)personalization, strlen(personalization));
+    if (ret == 0)
+        ret = mbedtls_x509_crt_parse(&ca, (const unsigned char *)TLS_ROOT_CA, strlen(TLS_ROOT_CA) + 1);
+    if (ret == 0)
+        ret = mbedtls_ssl_config_defaults(&conf, MBEDTLS_SSL_IS_CLIENT, MBEDTLS_SSL_TRANSPORT_STREAM,
+                                          MBEDTLS_SSL_PRESET_DEFAULT);
+    if (ret != 0)
+    {
+        LOG_ERROR("TLS: Configuration impossible (-0x%04x)\n", -ret);
+        return false;
+    }
+
+    mbedtls_ssl_conf_rng(&conf, mbedtls_ctr_drbg_random, &drbg);
+    mbedtls_ssl_conf_authmode(&conf, MBEDTLS_SSL_VERIFY_REQUIRED);
+    mbedtls_ssl_conf_ca_chain(&conf, &ca, NULL);
+    mbedtls_ssl_conf_min_version(&conf, MBEDTLS_SSL_MAJOR_VERSION_3, MBEDTLS_SSL_MINOR_VERSION_3);
+    mbedtls_ssl_conf_max_version(&conf, MBEDTLS_SSL_MAJOR_VERSION_3, MBEDTLS_SSL_MINOR_VERSION_3);
+    mbedtls_ssl_conf_ciphersuites(&conf, CIPHERSUITES);
+    mbedtls_ssl_conf_curves(&conf, CURVES);
+    mbedtls_ssl_conf_session_tickets(&conf, MBEDTLS_SSL_SESSION_TICKETS_ENABLED);
+    mbedtls_ssl_conf_verify(&conf, onVerify, this);
+
+    ret = mbedtls_ssl_setup(&ssl, &conf);
+    if (ret != 0)
+    {
+        LOG_ERROR("TLS: mbedtls_ssl_setup a échoué (-0x%04x)\n", -ret);
+        return false;
+    }
+    return true;
+}
+
+void TlsClient::releaseContexts()
+{
+    if (tls == NULL)
+        return;
+    mbedtls_ssl_free(&tls->ssl);
+    mbedtls_ssl_config_free(&tls->conf);
+    mbedtls_x509_crt_free(&tls->ca);
+    mbedtls_ctr_drbg_free(&tls->drbg);
+    mbedtls_entropy_free(&tls->entropy);
+    free(tls);
+    tls = NULL;
+}
+
+// Appelé pour chaque certificat de la chaîne reçue, donc uniquement lors d'un handshake
+// complet (une reprise n'envoie pas de certificat). Le verdict de mbedTLS est conservé.
+int TlsClient::onVerify(void *context, mbedtls_x509_crt *crt, int depth, uint32_t *flags)
+{
+    ((TlsClient *)context)->certificateVerified = true;
+    return 0;
+}
+
+// Handshake par l'API publique (mbedtls_ssl_handshake jusqu'à 0) : mbedTLS 2.x n'expose pas
+// l'état du handshake ; complet ou repris est déduit de la réception du certificat serveur
+bool TlsClient::handshake()
+{
+    mbedtls_ssl_context &ssl = tls->ssl;
+    bool offered = loadSession(ssl, host);
+    certificateVerified = false;
+    int32_t heapBaseline = heapMeasureStart();
+    int64_t start = esp_timer_get_time();
+    unsigned long deadline = millis() + TLS_HANDSHAKE_TIMEOUT;
+
+    int ret;
+    while ((ret = mbedtls_ssl_handshake(&ssl)) != 0)
+    {
+        heapMeasureSample();
+        if (ret != MBEDTLS_ERR_SSL_WANT_READ && ret != MBEDTLS_ERR_SSL_WANT_WRITE)
+        {
+            LOG_WARN("TLS: Handshake avec %s échoué (-0x%04x)\n", host, -ret);
+            return false;
+        }
+        if ((long)(millis() - deadline) > 0)
+        {
+            LOG_WARN("TLS: Timeout du handshake avec %s\n", host);
+            return false;
+        }
+        delay(1);
+    }
+
+    uint32_t durationUs = (uint32_t)(esp_timer_get_time() - start);
+    uint32_t heapUsed = heapMeasurePeak(heapBaseline);
+    bool resumed = offered && !certificateVerified;
+
+    portENTER_CRITICAL(&statsMux);
+    if (resumed)
+    {
+        stats.resumedCount++;
+        stats.lastResumedUs = durationUs;
+        stats.peakHeapResumed = max(stats.peakHeapResumed, heapUsed);
+    }
+    else
+    {
+        stats.fullCount++;
+        stats.lastFullUs = durationUs;
+        stats.peakHeapFull = max(stats.peakHeapFull, heapUsed);
+    }
+    portEXIT_CRITICAL(&statsMux);
+
+    LOG_INFO("TLS: Handshake %s avec %s en %lu µs (heap au pic : %lu octets)\n",
+             resumed ? "repris" : "complet", host, (unsigned long)durationUs, (unsigned long)heapUsed);
+    if (!resumed)
+    {
+        // Octets sur ESP-IDF (mots sur FreeRTOS d'origine)
+        uint32_t stackFree = uxTaskGetStackHighWaterMark(NULL);
+        recordStackFree(stackFree);
+        LOG_INFO("TLS: Pile libre au plus bas de %s : %lu octets\n", pcTaskGetName(NULL), (unsigned long)stackFree);
+    }
+
+    // Nouveau ticket : toujours en RTC, en NVS seulement après un handshake complet
+    storeSession(ssl, host, !resumed);
+    return true;
+}
+
+void TlsClient::reset()
+{
+    if (sslActive)
+    {
+        mbedtls_ssl_close_notify(&tls->ssl);
+        sslActive = false;
+    }
+    peeked = -1;
+}
+
+int TlsClient::connect(IPAddress ip, uint16_t port)
+{
+    return connect(ip.toString().c_str(), port, TLS_HANDSHAKE_TIMEOUT);
+}
+
+int TlsClient::connect(IPAddress ip, uint16_t port, int32_t timeout)
+{
+    return connect(ip.toString().c_str(), port, timeout);
+}
+
+int TlsClient::connect(const char *hostName, uint16_t port)
+{
+    return connect(hostName, port, TLS_HANDSHAKE_TIMEOUT);
+}
+
+int TlsClient::connect(const char *hostName, uint16_t port, int32_t timeout)
+{
+    stop();
+
+    if (!setupConfig())
+    {
+        releaseContexts();
+        return 0;
+    }
+
+    strncpy(host, hostName, sizeof(host) - 1);
+    host[sizeof(host) - 1] = '\0';
+
+    if (!tcp.connect(hostName, port, timeout))
+        return 0;
+
+    mbedtls_ssl_set_hostname(&tls->ssl, host);
+    mbedtls_ssl_set_bio(&tls->ssl, &tcp, sendCallback, recvCallback, NULL);
+    sslActive = true;
+
+    if (!handshake())
+    {
+        portENTER_CRITICAL(&statsMux);
+        stats.failedCount++;
+        portEXIT_CRITICAL(&statsMux);
+        stop();
+        return 0;
+    }
+    return 1;
+}
+
+size_t TlsClient::write(uint8_t data)
+{
+    return write(&data, 1);
+}
+
+size_t TlsClient::write(const uint8_t *buf, size_t size)
+{
+    if (!sslActive)
+        return 0;
+
+    size_t written = 0;
+    unsigned long deadline = millis() + TLS_HANDSHAKE_TIMEOUT;
+    while (written < size)
+    {
+        int ret = mbedtls_ssl_write(&tls->ssl, buf + written, size - written);
+        if (ret > 0)
+        {
+            written += ret;
+        }
+        else if ((ret != MBEDTLS_ERR_SSL_WANT_READ && ret != MBEDTLS_ERR_SSL_WANT_WRITE) ||
+                 (long)(millis() - deadline) > 0)
+        {
+            stop();
+            break;
+        }
+        else
+        {
+            delay(1);
+        }
+    }
+    return written;
+}
+
+int TlsClient::available()
+{
+    if (!sslActive)
+        return peeked >= 0 ? 1 : 0;
+
+    // Lecture vide : traite les enregistrements TLS reçus sans consommer de données
+    int ret = mbedtls_ssl_read(&tls->ssl, NULL, 0);
+    if (ret < 0 && ret != MBEDTLS_ERR_SSL_WANT_READ && ret != MBEDTLS_ERR_SSL_WANT_WRITE)
+    {
+        int pending = (peeked >= 0 ? 1 : 0) + (int)mbedtls_ssl_get_bytes_avail(&tls->ssl);
+        if (pending == 0)
+            stop();
+        return pending;
+    }
+    return (peeked >= 0 ? 1 : 0) + (int)mbedtls_ssl_get_bytes_avail(&tls->ssl);
+}
+
+int TlsClient::read()
+{
+    uint8_t data;
+    return read(&data, 1) == 1 ? data : -1;
+}
+
+int TlsClient::read(uint8_t *buf, size_t size)
+{
+    if (size == 0)
+        return 0;
+
+    int offset = 0;
+    if (peeked >= 0)
+    {
+        buf[0] = (uint8_t)peeked;
+        peeked = -1;
+        offset = 1;
+        if (size == 1 || !sslActive)
+            return 1;
+    }
+
+    if (!sslActive || available() <= 0)
+        return offset > 0 ? offset : -1;
+
+    int ret = mbedtls_ssl_read(&tls->ssl, buf + offset, size - offset);
+    if (ret > 0)
+        return ret + offset;
+    return offset > 0 ? offset : -1;
+}
+
+int TlsClient::peek()
+{
+    if (peeked < 0)
+        peeked = read();
+    return peeked;
+}
+
+void TlsClient::stop()
+{
+    reset();
+    tcp.stop();
+    releaseContexts();
+}
+
+uint8_t TlsClient::connected()
+{
+    if (!sslActive)
+        return peeked >= 0;
+    return tcp.connected() || mbedtls_ssl_get_bytes_avail(&tls->ssl) > 0;
+}
+
+int TlsClient::setTimeout(uint32_t seconds)
+{
+    return tcp.setTimeout(seconds);
+}
@@ -0,0 +1,85 @@
+#pragma once
+#include <Arduino.h>
+#include <WiFiClient.h>
+#include <mbedtls/ssl.h>
+#include <mbedtls/entropy.h>
+#include <mbedtls/ctr_drbg.h>
+#include <mbedtls/x509_crt.h>
+
+// ======== CONFIGURATION ========
+// Session sérialisée par mbedTLS 2.28 : ~110 octets + certificat feuille du serveur (DER) +
+// ticket. Serveur de test : 405 + 176, soit ~690 octets. Une session plus grande (feuille
+// d'une CA publique avec SCT, ~1,2 Ko) n'est pas mise en cache : journalisée et comptée.
+#define TLS_SESSION_MAX_SIZE 1024   // Taille max d'une session sérialisée (ticket + certificat pair)
+#define TLS_SESSION_CACHE_SLOTS 2   // Hôtes distincts mis en cache (heartbeat, OTA...)
+#define TLS_HANDSHAKE_TIMEOUT 10000 // Timeout du handshake (ms)
+#define TLS_STACK_TASKS 3           // Tâches suivies pour la pile (heartbeat, téléchargement du modèle, loop / OTA)
+
+// Statistiques des handshakes, pour comparer complet / repris
+struct TlsHandshakeStats
+{
+    uint32_t fullCount;
+    uint32_t resumedCount;
+    uint32_t failedCount;
+    uint32_t lastFullUs;     // durée du dernier handshake complet (µs)
+    uint32_t lastResumedUs;  // durée du dernier handshake repris (µs)
+    uint32_t peakHeapFull;   // allocations mbedTLS au pic pendant un handshake complet (octets)
+    uint32_t peakHeapResumed;
+    uint32_t sessionTooLarge; // sessions non mises en cache, plus grandes que TLS_SESSION_MAX_SIZE
+    // Pile jamais utilisée de chaque tâche ayant fait un handshake complet (le plus profond),
+    // relevée par uxTaskGetStackHighWaterMark juste après ; nom vide : entrée libre
+    char stackTask[TLS_STACK_TASKS][16];
+    uint32_t stackFreeMin[TLS_STACK_TASKS]; // octets
+};
+
+// Contextes mbedTLS (plusieurs Ko) : alloués sur le heap à la connexion, libérés par stop(),
+// pour ne pas peser sur la pile des tâches qui déclarent un TlsClient local
+struct TlsContexts;
+
+// Client TLS 1.2 pour HTTPClient / HTTPUpdate :
+// suites ECDHE-ECDSA uniquement (courbe P-256), reprise de session par ticket ou ID
+// avec un cache en RTC (survit aux redémarrages logiciels) recopié en NVS.
+class TlsClient : public WiFiClient
+{
+private:
+    WiFiClient tcp;
+    TlsContexts *tls = NULL;
+    bool sslActive = false;
+    char host[48] = "";
+    int peeked = -1;
+    bool certificateVerified = false; // chaîne du serveur reçue : handshake complet
+
+    static int onVerify(void *context, mbedtls_x509_crt *crt, int depth, uint32_t *flags);
+    bool setupConfig();
+    void releaseContexts();
+    bool handshake();
+    void reset();
+
+public:
+    TlsClient();
+    ~TlsClient();
+
+    int connect(IPAddress ip, uint16_t port);
+    int connect(IPAddress ip, uint16_t port, int32_t timeout);
+    int connect(const char *host, uint16_t port);
+    int connect(const char *host, uint16_t port, int32_t timeout);
+    size_t write(uint8_t data);
+    size_t write(const uint8_t *buf, size_t size);
+    int available();
+    int read();
+    int read(uint8_t *buf, size_t size);
+    int peek();
+    void flush() {}
+    void stop();
+    uint8_t connected();
+    int setTimeout(uint32_t seconds);
+    operator bool() { return connected(); }
+
+    using Print::write;
+};
+
+// Recharger le cache de sessions depuis la NVS si la RTC a été perdue (à appeler au démarrage)
+void tlsSessionCacheInit();
+
+// Statistiques cumulées de tous les clients TLS
+TlsHandshakeStats tlsGetHandshakeStats();
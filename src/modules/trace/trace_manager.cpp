@@ -0,0 +1,147 @@
+#include "trace_manager.h"
+#include <modules/log/log_manager.h>
+#include <atomic>
+
+static_assert((TRACE_RING_SIZE & (TRACE_RING_SIZE - 1)) == 0, "TRACE_RING_SIZE doit être une puissance de 2");
+
+// Ring écrasant les plus anciens événements ; une case est réservée par fetch_add.
+// Chaque case porte un numéro de séquence (verrou de séquence) : 2 * position + 1 pendant
+// l'écriture, 2 * position + 2 une fois l'événement complet. Une lecture concurrente d'une
+// écriture, ou d'une case déjà réutilisée pour un événement plus récent, est écartée.
+struct TraceSlot
+{
+    std::atomic<uint32_t> sequence;
+    TraceEvent event;
+};
+
+static TraceSlot slots[TRACE_RING_SIZE];
+static std::atomic<uint32_t> nextEvent(0);
+static volatile bool uploadRequested = false;
+
+// Dump en cours (loop uniquement) : positions [dumpNext, dumpEnd) restant à écrire
+static std::atomic<bool> dumping(false);
+static uint32_t dumpNext = 0;
+static uint32_t dumpEnd = 0;
+
+#if TRACE_ENABLED
+TraceScope::~TraceScope()
+{
+    traceRecord(name, start, (uint32_t)(esp_timer_get_time() - start));
+}
+#endif
+
+void traceRecord(const char *name, uint64_t start, uint32_t duration)
+{
+    if (dumping.load(std::memory_order_relaxed))
+        return;
+
+    uint32_t position = nextEvent.fetch_add(1, std::memory_order_relaxed);
+    TraceSlot &slot = slots[position & (TRACE_RING_SIZE - 1)];
+
+    slot.sequence.store(2 * position + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.event.name = name;
+    slot.event.start = start;
+    slot.event.duration = duration;
+    slot.event.core = xPortGetCoreID();
+    strncpy(slot.event.task, pcTaskGetName(NULL), TRACE_TASK_NAME_LEN - 1);
+    slot.event.task[TRACE_TASK_NAME_LEN - 1] = '\0';
+    slot.sequence.store(2 * position + 2, std::memory_order_release);
+}
+
+// Lire l'événement de la position donnée ; false s'il est en cours d'écriture ou déjà écrasé
+static bool readEvent(uint32_t position, TraceEvent &out)
+{
+    const TraceSlot &slot = slots[position & (TRACE_RING_SIZE - 1)];
+    uint32_t expected = 2 * position + 2;
+    if (slot.sequence.load(std::memory_order_acquire) != expected)
+        return false;
+
+    memcpy(&out, &slot.event, sizeof(out));
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return slot.sequence.load(std::memory_order_relaxed) == expected;
+}
+
+// Positions des `count` derniers événements : [first, end)
+static uint32_t lastEvents(int count, uint32_t &end)
+{
+    end = nextEvent.load(std::memory_order_acquire);
+    uint32_t available = end < TRACE_RING_SIZE ? end : TRACE_RING_SIZE;
+    if ((uint32_t)count > available)
+        count = available;
+    return end - count;
+}
+
+// Écrire le lot suivant du dump en cours. Les lignes passent par logWrite au niveau INFO
+// sans le filtre LOG_LEVEL : le dump est demandé explicitement
+static void continueDump()
+{
+    // La moitié du ring des logs reste aux autres messages
+    int budget = TRACE_DUMP_BATCH;
+    while (dumpNext != dumpEnd && budget > 0 && logManagerGetFreeCount() > LOG_RING_SIZE / 2)
+    {
+        // Lecture case par case, sans copie de tout le ring ; les cases écartées ne sont pas écrites
+        TraceEvent event;
+        if (readEvent(dumpNext++, event))
+        {
+            logWrite(LOG_LEVEL_INFO, "TRACE %s,%u,%s,%llu,%lu",
+                     event.name, event.core, event.task, event.start, event.duration);
+            budget--;
+        }
+    }
+
+    if (dumpNext == dumpEnd && logManagerGetFreeCount() > LOG_RING_SIZE / 2)
+    {
+        logWrite(LOG_LEVEL_INFO, "TRACE_END");
+        dumping.store(false, std::memory_order_relaxed);
+    }
+}
+
+void traceManagerProcess()
+{
+    while (Serial.available() > 0)
+    {
+        if (Serial.read() == 't')
+            traceManagerDumpSerial();
+    }
+    if (dumping.load(std::memory_order_relaxed))
+        continueDump();
+}
+
+void traceManagerDumpSerial()
+{
+    if (dumping.load(std::memory_order_relaxed))
+        return;
+    dumping.store(true, std::memory_order_relaxed);
+    dumpNext = lastEvents(TRACE_RING_SIZE, dumpEnd);
+    logWrite(LOG_LEVEL_INFO, "TRACE_BEGIN %lu", (unsigned long)(dumpEnd - dumpNext));
+}
+
+void traceManagerRequestUpload()
+{
+    uploadRequested = true;
+}
+
+void traceManagerAddToJson(JsonDocument &doc)
+{
+    if (!uploadRequested)
+        return;
+    uploadRequested = false;
+
+    uint32_t end;
+    uint32_t first = lastEvents(TRACE_UPLOAD_MAX, end);
+
+    JsonArray trace = doc.createNestedArray("trace");
+    for (uint32_t position = first; position != end; position++)
+    {
+        TraceEvent event;
+        if (!readEvent(position, event))
+            continue;
+        JsonObject entry = trace.createNestedObject();
+        entry["name"] = event.name;
+        entry["core"] = event.core;
+        entry["task"] = event.task; // tableau non const : copié dans le document
+        entry["ts"] = event.start;
+        entry["dur"] = event.duration;
+    }
+}
@@ -0,0 +1,71 @@
+#pragma once
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+// ======== CONFIGURATION ========
+// TRACE_ENABLED 0 (via build_flags) supprime toute l'instrumentation à la compilation
+#ifndef TRACE_ENABLED
+#define TRACE_ENABLED 1
+#endif
+#define TRACE_RING_SIZE 256 // Événements conservés (puissance de 2)
+#define TRACE_UPLOAD_MAX 64 // Événements envoyés au plus par heartbeat
+#define TRACE_TASK_NAME_LEN 16 // configMAX_TASK_NAME_LEN de l'ESP32
+#define TRACE_DUMP_BATCH 4     // Lignes de dump émises au plus par appel de traceManagerProcess
+
+// ======== STRUCTURE ========
+struct TraceEvent
+{
+    const char *name;               // littéral, jamais copié
+    uint64_t start;                 // µs depuis le démarrage (64 bits : pas de rebouclage à 71 min)
+    uint32_t duration;              // µs
+    uint8_t core;
+    char task[TRACE_TASK_NAME_LEN]; // nom copié à l'enregistrement (la tâche peut avoir disparu au dump)
+};
+
+#if TRACE_ENABLED
+
+// Mesure d'une portée : début à la construction, enregistrement à la destruction
+class TraceScope
+{
+private:
+    const char *name;
+    uint64_t start;
+
+public:
+    explicit TraceScope(const char *name) : name(name), start(esp_timer_get_time()) {}
+    ~TraceScope();
+};
+
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+#define TRACE_SCOPE(name) TraceScope TRACE_CONCAT(traceScope, __LINE__)(name)
+
+#else
+
+#define TRACE_SCOPE(name) \
+    do                    \
+    {                     \
+    } while (0)
+
+#endif
+
+// ======== FONCTIONS PUBLIQUES ========
+void traceRecord(const char *name, uint64_t start, uint32_t duration);
+
+// Lecture des commandes sur le port série ('t' : dump de la trace) et poursuite du dump en cours
+void traceManagerProcess();
+
+// Démarrer un dump texte via les logs, à convertir avec tools/trace_to_chrome.py. Le dump est
+// émis par lots de TRACE_DUMP_BATCH lignes à chaque traceManagerProcess, quand le ring des
+// logs a de la place : la loop n'attend jamais le port série. L'enregistrement est suspendu
+// jusqu'à la fin du dump, pour que les événements ne soient pas écrasés avant d'être écrits.
+void traceManagerDumpSerial();
+
+// Demander l'ajout de la trace au prochain heartbeat
+void traceManagerRequestUpload();
+
+// Ajouter les derniers événements au payload du heartbeat si demandé
+void traceManagerAddToJson(JsonDocument &doc);
@@ -0,0 +1,59 @@
+#include "wifi_connect.h"
+
+void wifiConnectStart(WifiConnectState &state)
+{
+    state.currentIndex = 0;
+    state.attemptStart = 0;
+    state.attemptStarted = false;
+    state.connecting = true;
+    state.lastAllCheck = 0;
+}
+
+WifiConnectAction wifiConnectStep(WifiConnectState &state, bool linkUp, uint32_t now, int networkCount)
+{
+    // Si déjà connecté et pas en phase de tentative, on ne fait rien
+    if (linkUp && !state.connecting)
+        return WIFI_ACTION_NONE;
+
+    // Si pas connecté et pas déjà en tentative -> relancer une recherche, pas avant l'intervalle
+    if (!state.connecting)
+    {
+        if (now - state.lastAllCheck <= WIFI_RETRY_INTERVAL)
+            return WIFI_ACTION_NONE;
+        state.currentIndex = 0;
+        state.attemptStarted = false;
+        state.connecting = true;
+    }
+
+    // Si on a dépassé tous les réseaux connus
+    if (state.currentIndex >= networkCount)
+    {
+        state.connecting = false;
+        state.lastAllCheck = now;
+        return WIFI_ACTION_GAVE_UP;
+    }
+
+    // Si on vient de démarrer une tentative
+    if (!state.attemptStarted)
+    {
+        state.attemptStarted = true;
+        state.attemptStart = now;
+        return WIFI_ACTION_BEGIN;
+    }
+
+    // Vérification si connexion réussie
+    if (linkUp)
+    {
+        state.connecting = false;
+        return WIFI_ACTION_CONNECTED;
+    }
+
+    // Timeout → essai réseau suivant
+    if (now - state.attemptStart > WIFI_ATTEMPT_TIMEOUT)
+    {
+        state.currentIndex++;
+        state.attemptStarted = false;
+        return WIFI_ACTION_FAILED;
+    }
+    return WIFI_ACTION_NONE;
+}
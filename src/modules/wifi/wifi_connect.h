@@ -0,0 +1,31 @@
+#pragma once
+#include <stdint.h>
+
+// ======== CONFIGURATION ========
+#define WIFI_ATTEMPT_TIMEOUT 8000 // Durée max d'un essai sur un réseau (ms)
+#define WIFI_RETRY_INTERVAL 30000 // Attente avant de reparcourir la liste des réseaux (ms)
+
+// Machine d'état de connexion, sans accès au matériel : wifiConnectStep() dit quoi faire,
+// wifi_manager.cpp l'applique avec WiFi.*, le simulateur de flotte avec ses fakes.
+struct WifiConnectState
+{
+    int currentIndex;       // réseau en cours d'essai
+    uint32_t attemptStart;  // début de l'essai courant (ms)
+    bool attemptStarted;    // WiFi.begin() appelé pour le réseau courant
+    bool connecting;        // parcours de la liste en cours
+    uint32_t lastAllCheck;  // fin du dernier parcours infructueux (ms)
+};
+
+enum WifiConnectAction : uint8_t
+{
+    WIFI_ACTION_NONE = 0,
+    WIFI_ACTION_BEGIN,      // lancer WiFi.begin() sur currentIndex
+    WIFI_ACTION_CONNECTED,  // connexion établie sur currentIndex
+    WIFI_ACTION_FAILED,     // essai expiré : WiFi.disconnect(), currentIndex a avancé
+    WIFI_ACTION_GAVE_UP,    // tous les réseaux essayés, nouvel essai dans WIFI_RETRY_INTERVAL
+};
+
+void wifiConnectStart(WifiConnectState &state);
+
+// Avancer d'un pas ; linkUp = WiFi.status() == WL_CONNECTED
+WifiConnectAction wifiConnectStep(WifiConnectState &state, bool linkUp, uint32_t now, int networkCount);
@@ -1,73 +1,50 @@
 #include "wifi_manager.h"
 #include <WiFi.h>
+#include <modules/log/log_manager.h>
+#include <modules/trace/trace_manager.h>
+#include "wifi_connect.h"
 
 const char *ssidList[] = {"ASTRARL"};
 const char *passList[] = {"strombolicaca"};
 const int nbReseaux = sizeof(ssidList) / sizeof(ssidList[0]);
 
-static int wifiCurrentIndex = 0;
-static unsigned long wifiAttemptStart = 0;
-static bool wifiConnecting = false;
-static unsigned long lastAllWifiCheck = 0;
+static WifiConnectState wifiState;
 
 // À appeler une seule fois au démarrage
 void wifiManagerInit()
 {
     Serial.println("Tentative de connexion au Wi-Fi...");
     WiFi.mode(WIFI_STA);
-    wifiCurrentIndex = 0;
-    wifiConnecting = true;
-    wifiAttemptStart = 0;
+    wifiConnectStart(wifiState);
 }
 
 // À appeler régulièrement dans la loop principale
 void wifiManagerProcess()
 {
-    // Si déjà connecté et pas en phase de tentative, on ne fait rien
-    if (WiFi.status() == WL_CONNECTED && !wifiConnecting)
-        return;
+    TRACE_SCOPE("wifiManagerProcess");
 
-    // Si pas connecté et pas déjà en tentative -> relancer une recherche
-    if (!wifiConnecting && millis() - lastAllWifiCheck > 30000)
+    bool wasConnecting = wifiState.connecting;
+    int index = wifiState.currentIndex;
+    switch (wifiConnectStep(wifiState, WiFi.status() == WL_CONNECTED, millis(), nbReseaux))
     {
-        Serial.println("Nouvelle tentative de connexion aux réseaux Wi-Fi connus...");
-        wifiCurrentIndex = 0;
-        wifiConnecting = true;
-        wifiAttemptStart = 0;
-    }
-
-    // Si on a dépassé tous les réseaux connus
-    if (wifiCurrentIndex >= nbReseaux)
-    {
-        Serial.println("Impossible de se connecter à un réseau après tous les essais.");
-        wifiConnecting = false;
-        lastAllWifiCheck = millis();
-        return;
-    }
-
-    // Si on vient de démarrer une tentative
-    if (wifiAttemptStart == 0)
-    {
-        Serial.printf("Essai de connexion à %s...\n", ssidList[wifiCurrentIndex]);
-        WiFi.begin(ssidList[wifiCurrentIndex], passList[wifiCurrentIndex]);
-        wifiAttemptStart = millis();
-    }
-
-    // Vérification si connexion réussie
-    if (WiFi.status() == WL_CONNECTED)
-    {
-        Serial.printf("✅ Connecté à %s\n", ssidList[wifiCurrentIndex]);
-        Serial.print("Adresse IP : ");
-        Serial.println(WiFi.localIP());
-        wifiConnecting = false;
-    }
-    // Timeout de 8 secondes → essai réseau suivant
-    else if (millis() - wifiAttemptStart > 8000)
-    {
-        Serial.printf("❌ Échec sur %s\n", ssidList[wifiCurrentIndex]);
+    case WIFI_ACTION_BEGIN:
+        if (!wasConnecting)
+            LOG_INFO("Nouvelle tentative de connexion aux réseaux Wi-Fi connus...");
+        LOG_INFO("Essai de connexion à %s...\n", ssidList[wifiState.currentIndex]);
+        WiFi.begin(ssidList[wifiState.currentIndex], passList[wifiState.currentIndex]);
+        break;
+    case WIFI_ACTION_CONNECTED:
+        LOG_INFO("✅ Connecté à %s (IP : %s)\n", ssidList[index], WiFi.localIP().toString());
+        break;
+    case WIFI_ACTION_FAILED:
+        LOG_WARN("❌ Échec sur %s\n", ssidList[index]);
         WiFi.disconnect(true);
-        wifiCurrentIndex++;
-        wifiAttemptStart = 0;
+        break;
+    case WIFI_ACTION_GAVE_UP:
+        LOG_WARN("Impossible de se connecter à un réseau après tous les essais.");
+        break;
+    default:
+        break;
     }
 }
 
@@ -0,0 +1,126 @@
+// Extraction des caractéristiques acoustiques (FFT portable, celle du build hôte) sur des
+// blocs synthétiques, puis mesure du débit en blocs par seconde.
+//
+//   pio test -e native -f test_acoustic_dsp -v
+#include <unity.h>
+#include <modules/acoustic/acoustic_dsp.h>
+#include <math.h>
+#include <stdio.h>
+#include <time.h>
+
+#define BENCHMARK_BLOCKS 200000
+#define BENCHMARK_VARIANTS 16 // blocs différents, pour ne pas mesurer un seul motif en cache
+
+static uint16_t block[ACOUSTIC_FFT_SIZE];
+
+static void fillTone(uint16_t *samples, float frequency, float amplitude)
+{
+    for (int i = 0; i < ACOUSTIC_FFT_SIZE; i++)
+        samples[i] = (uint16_t)(2048.0f + amplitude * sinf(2.0f * (float)M_PI * frequency * i / ACOUSTIC_SAMPLE_RATE));
+}
+
+static void fillNoise(uint16_t *samples, uint32_t seed)
+{
+    for (int i = 0; i < ACOUSTIC_FFT_SIZE; i++)
+    {
+        seed = seed * 1103515245u + 12345u;
+        samples[i] = (seed >> 16) & 0x0FFF;
+    }
+}
+
+static int loudestBand(const AcousticFeatures &features)
+{
+    int loudest = 0;
+    for (int b = 1; b < ACOUSTIC_BAND_COUNT; b++)
+    {
+        if (features.bandDb[b] > features.bandDb[loudest])
+            loudest = b;
+    }
+    return loudest;
+}
+
+static double nowSeconds()
+{
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec * 1e-9;
+}
+
+void setUp()
+{
+    TEST_ASSERT_TRUE(acousticDspInit());
+}
+
+void tearDown() {}
+
+void test_tone_lands_in_its_band()
+{
+    const float binWidth = (float)ACOUSTIC_SAMPLE_RATE / ACOUSTIC_FFT_SIZE;
+    for (int b = 0; b < ACOUSTIC_BAND_COUNT - 1; b++) // la bande 4 kHz est coupée par Nyquist
+    {
+        AcousticFeatures features;
+        fillTone(block, ACOUSTIC_BAND_CENTERS[b], 1000.0f);
+        acousticComputeFeatures(block, features);
+        TEST_ASSERT_EQUAL_INT(b, loudestBand(features));
+        TEST_ASSERT_FLOAT_WITHIN(binWidth, ACOUSTIC_BAND_CENTERS[b], features.centroidHz);
+        TEST_ASSERT_LESS_THAN(0.1f, features.flatness);
+    }
+}
+
+void test_noise_is_flat()
+{
+    AcousticFeatures features;
+    fillNoise(block, 1);
+    acousticComputeFeatures(block, features);
+    TEST_ASSERT_GREATER_THAN(0.4f, features.flatness);
+    TEST_ASSERT_FLOAT_WITHIN(500.0f, ACOUSTIC_SAMPLE_RATE / 4.0f, features.centroidHz);
+}
+
+void test_silence_has_no_centroid()
+{
+    AcousticFeatures features;
+    for (int i = 0; i < ACOUSTIC_FFT_SIZE; i++)
+        block[i] = 2048;
+    acousticComputeFeatures(block, features);
+    TEST_ASSERT_EQUAL_INT(0, (int)features.centroidHz);
+    TEST_ASSERT_EQUAL_INT(0, (int)features.flatness);
+}
+
+// Débit de acousticComputeFeatures sur des blocs synthétiques (ton + bruit)
+void test_benchmark_blocks_per_second()
+{
+    static uint16_t variants[BENCHMARK_VARIANTS][ACOUSTIC_FFT_SIZE];
+    for (int v = 0; v < BENCHMARK_VARIANTS; v++)
+    {
+        fillNoise(variants[v], v + 1);
+        for (int i = 0; i < ACOUSTIC_FFT_SIZE; i++)
+            variants[v][i] = (variants[v][i] >> 2) + 1536 + (uint16_t)(500.0f * sinf(0.3f * (v + 1) * i));
+    }
+
+    AcousticFeatures features;
+    float checksum = 0.0f;
+    double start = nowSeconds();
+    for (int i = 0; i < BENCHMARK_BLOCKS; i++)
+    {
+        acousticComputeFeatures(variants[i % BENCHMARK_VARIANTS], features);
+        checksum += features.centroidHz;
+    }
+    double elapsed = nowSeconds() - start;
+
+    char message[160];
+    snprintf(message, sizeof(message), "%.0f blocs/s (%.2f us/bloc, FFT %s %d points), somme de contrôle %.0f",
+             BENCHMARK_BLOCKS / elapsed, elapsed * 1e6 / BENCHMARK_BLOCKS,
+             ACOUSTIC_USE_ESP_DSP ? "esp-dsp" : "portable", ACOUSTIC_FFT_SIZE, checksum);
+    TEST_MESSAGE(message);
+    TEST_ASSERT_GREATER_THAN(0.0f, checksum);
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_tone_lands_in_its_band);
+    RUN_TEST(test_noise_is_flat);
+    RUN_TEST(test_silence_has_no_centroid);
+    RUN_TEST(test_benchmark_blocks_per_second);
+    return UNITY_END();
+}
@@ -0,0 +1,327 @@
+// Capture rapide sans le matériel : détecteur de montée, ring pré-déclenchement, machine
+// d'état des emplacements (dont la remise entre le timer et la tâche heartbeat, exercée par
+// deux threads) et mesure de la cadence du callback.
+//
+//   pio test -e native -f test_burst_capture
+#include <unity.h>
+#include <modules/burst/burst_recorder.h>
+#include <atomic>
+#include <thread>
+
+#define VALUE_MASK 0xFFF
+
+static BurstRecorder recorder;
+
+// Compteur sur 12 bits, 4 bits par canal : assez pour vérifier l'ordre dans une capture,
+// trop peu d'amplitude (15 pas d'ADC) pour déclencher le détecteur
+static BurstSample makeSample(uint32_t value)
+{
+    BurstSample sample;
+    sample.mq135 = value & 0xF;
+    sample.mq136 = (value >> 4) & 0xF;
+    sample.mq4 = (value >> 8) & 0xF;
+    return sample;
+}
+
+static uint32_t sampleValue(const BurstSample &sample)
+{
+    return sample.mq135 | sample.mq136 << 4 | sample.mq4 << 8;
+}
+
+static BurstSample flatSample(uint16_t mq135, uint16_t mq136, uint16_t mq4)
+{
+    BurstSample sample;
+    sample.mq135 = mq135;
+    sample.mq136 = mq136;
+    sample.mq4 = mq4;
+    return sample;
+}
+
+// count échantillons à 1 kHz à partir de time ; retourne le nombre de captures démarrées
+static int feed(uint32_t &time, uint32_t count, int trigger = -1)
+{
+    int started = 0;
+    for (uint32_t i = 0; i < count; i++, time++)
+        started += burstRecorderAddSample(recorder, makeSample(time), time, trigger);
+    return started;
+}
+
+void setUp()
+{
+    burstRecorderInit(recorder);
+}
+
+void tearDown() {}
+
+// ======== DÉTECTEUR ========
+
+void test_detector_ignores_noise_and_drift()
+{
+    BurstDetector detector;
+    burstDetectorReset(detector);
+    uint32_t seed = 1;
+    for (int i = 0; i < 20000; i++)
+    {
+        seed = seed * 1103515245 + 12345;
+        int noise = (int)((seed >> 16) % 17) - 8;    // ±8 pas d'ADC
+        uint16_t drift = 1000 + i / 50;               // 20 pas/s
+        BurstSample sample = flatSample(drift + noise, 2000 - noise, 500 + noise);
+        TEST_ASSERT_EQUAL_INT(-1, burstDetectorUpdate(detector, sample));
+    }
+}
+
+void test_detector_triggers_on_rise_per_channel()
+{
+    for (int channel = 0; channel < BURST_CHANNEL_COUNT; channel++)
+    {
+        BurstDetector detector;
+        burstDetectorReset(detector);
+        for (int i = 0; i < 1000; i++)
+            TEST_ASSERT_EQUAL_INT(-1, burstDetectorUpdate(detector, flatSample(1000, 1000, 1000)));
+
+        // Marche de 4 fois le seuil : détectée en quelques ms
+        uint16_t values[BURST_CHANNEL_COUNT] = {1000, 1000, 1000};
+        values[channel] += 4 * BURST_GAS_TRIGGER_ADC;
+        int delay = 0, trigger = -1;
+        while (trigger < 0 && delay < 50)
+        {
+            trigger = burstDetectorUpdate(detector, flatSample(values[0], values[1], values[2]));
+            delay++;
+        }
+        TEST_ASSERT_EQUAL_INT(channel, trigger);
+        TEST_ASSERT_LESS_OR_EQUAL(10, delay);
+    }
+}
+
+void test_detector_ignores_fall()
+{
+    BurstDetector detector;
+    burstDetectorReset(detector);
+    for (int i = 0; i < 1000; i++)
+        burstDetectorUpdate(detector, flatSample(3000, 3000, 3000));
+    for (int i = 0; i < 1000; i++)
+        TEST_ASSERT_EQUAL_INT(-1, burstDetectorUpdate(detector, flatSample(100, 100, 100)));
+}
+
+// ======== ENREGISTREUR ========
+
+void test_no_capture_before_history_is_full()
+{
+    uint32_t time = 0;
+    TEST_ASSERT_EQUAL_INT(0, feed(time, BURST_PRETRIGGER_SAMPLES - 1, BURST_TRIGGER_MIC));
+    TEST_ASSERT_EQUAL_INT(1, feed(time, 1, BURST_TRIGGER_MIC));
+}
+
+void test_capture_holds_history_then_following_samples()
+{
+    uint32_t time = 0;
+    feed(time, 300);
+    uint32_t triggerValue = time;
+    TEST_ASSERT_TRUE(burstRecorderAddSample(recorder, makeSample(time), time, BURST_TRIGGER_MQ4));
+    time++;
+
+    size_t size;
+    TEST_ASSERT_NULL(burstRecorderAcquire(recorder, size)); // en cours d'enregistrement
+    feed(time, BURST_POSTTRIGGER_SAMPLES - 1);
+    TEST_ASSERT_NULL(burstRecorderAcquire(recorder, size));
+    feed(time, 1);
+
+    const BurstCapture *capture = burstRecorderAcquire(recorder, size);
+    TEST_ASSERT_NOT_NULL(capture);
+    TEST_ASSERT_EQUAL_UINT32(sizeof(BurstCaptureHeader) + BURST_CAPTURE_SAMPLES * sizeof(BurstSample), size);
+    TEST_ASSERT_EQUAL_UINT32(BURST_MAGIC, capture->header.magic);
+    TEST_ASSERT_EQUAL_INT(BURST_TRIGGER_MQ4, capture->header.trigger);
+    TEST_ASSERT_EQUAL_INT(BURST_PRETRIGGER_SAMPLES, capture->header.preTriggerSamples);
+    TEST_ASSERT_EQUAL_INT(BURST_CAPTURE_SAMPLES, capture->header.sampleCount);
+    TEST_ASSERT_EQUAL_UINT32(triggerValue, capture->header.triggerTime);
+    TEST_ASSERT_EQUAL_UINT32(1, capture->header.captureId);
+
+    // L'historique se termine par l'échantillon déclencheur, la suite est continue
+    uint32_t first = triggerValue - (BURST_PRETRIGGER_SAMPLES - 1);
+    for (int i = 0; i < BURST_CAPTURE_SAMPLES; i++)
+        TEST_ASSERT_EQUAL_UINT32((first + i) & VALUE_MASK, sampleValue(capture->samples[i]));
+    TEST_ASSERT_EQUAL_UINT32(1, recorder.recorded);
+}
+
+void test_rearm_delay_and_busy_recording()
+{
+    uint32_t time = 0;
+    feed(time, BURST_PRETRIGGER_SAMPLES);
+    TEST_ASSERT_EQUAL_INT(1, feed(time, 1, BURST_TRIGGER_MIC));
+    uint32_t triggerTime = time - 1;
+
+    // Déclenchements ignorés pendant la capture puis jusqu'au réarmement
+    TEST_ASSERT_EQUAL_INT(0, feed(time, triggerTime + BURST_REARM_MS - time, BURST_TRIGGER_MIC));
+    TEST_ASSERT_EQUAL_INT(1, feed(time, 1, BURST_TRIGGER_MIC));
+    TEST_ASSERT_EQUAL_UINT32(0, recorder.dropped);
+}
+
+void test_trigger_without_free_slot_is_dropped()
+{
+    uint32_t time = 0;
+    feed(time, BURST_PRETRIGGER_SAMPLES);
+    for (int i = 0; i < BURST_CAPTURE_SLOTS; i++)
+        TEST_ASSERT_EQUAL_INT(1, feed(time, BURST_REARM_MS, BURST_TRIGGER_MIC));
+    TEST_ASSERT_EQUAL_UINT32(BURST_CAPTURE_SLOTS, recorder.recorded);
+
+    TEST_ASSERT_EQUAL_INT(0, feed(time, 1, BURST_TRIGGER_MIC));
+    TEST_ASSERT_EQUAL_UINT32(1, recorder.dropped);
+    // Le délai de réarmement s'applique aussi à un déclenchement perdu
+    TEST_ASSERT_EQUAL_INT(0, feed(time, 10, BURST_TRIGGER_MIC));
+    TEST_ASSERT_EQUAL_UINT32(1, recorder.dropped);
+}
+
+void test_release_results()
+{
+    uint32_t time = 0;
+    feed(time, BURST_PRETRIGGER_SAMPLES);
+    for (int i = 0; i < BURST_CAPTURE_SLOTS; i++)
+        feed(time, BURST_REARM_MS, BURST_TRIGGER_MIC);
+
+    // La plus ancienne d'abord ; un nouvel essai la repropose
+    size_t size;
+    const BurstCapture *capture = burstRecorderAcquire(recorder, size);
+    TEST_ASSERT_EQUAL_UINT32(1, capture->header.captureId);
+    burstRecorderRelease(recorder, capture, BURST_UPLOAD_RETRY);
+    capture = burstRecorderAcquire(recorder, size);
+    TEST_ASSERT_EQUAL_UINT32(1, capture->header.captureId);
+
+    // Refusée (4xx) : abandonnée, l'emplacement est libre
+    burstRecorderRelease(recorder, capture, BURST_UPLOAD_REJECTED);
+    TEST_ASSERT_EQUAL_UINT32(1, recorder.rejected);
+    TEST_ASSERT_EQUAL_UINT32(0, recorder.uploaded);
+    burstRecorderRelease(recorder, capture, BURST_UPLOAD_OK); // déjà rendue : ignorée
+    TEST_ASSERT_EQUAL_UINT32(0, recorder.uploaded);
+
+    capture = burstRecorderAcquire(recorder, size);
+    TEST_ASSERT_EQUAL_UINT32(2, capture->header.captureId);
+    burstRecorderRelease(recorder, capture, BURST_UPLOAD_OK);
+    TEST_ASSERT_EQUAL_UINT32(1, recorder.uploaded);
+    TEST_ASSERT_NULL(burstRecorderAcquire(recorder, size));
+
+    // Les deux emplacements sont de nouveau utilisables
+    for (int i = 0; i < BURST_CAPTURE_SLOTS; i++)
+        TEST_ASSERT_EQUAL_INT(1, feed(time, BURST_REARM_MS, BURST_TRIGGER_MIC));
+    TEST_ASSERT_EQUAL_UINT32(0, recorder.dropped);
+}
+
+// Timer et tâche heartbeat sur deux threads : aucune capture ne doit être lue incomplète
+// ou réécrite pendant son envoi
+void test_concurrent_producer_and_consumer()
+{
+    const uint32_t SAMPLE_COUNT = 3000000;
+    std::atomic<bool> done(false);
+    uint32_t corrupted = 0, consumed = 0, lastId = 0;
+
+    std::thread consumer([&]()
+    {
+        uint32_t retries = 0;
+        while (true)
+        {
+            bool finished = done.load();
+            size_t size;
+            const BurstCapture *capture = burstRecorderAcquire(recorder, size);
+            if (capture == NULL)
+            {
+                if (finished)
+                    break;
+                std::this_thread::yield();
+                continue;
+            }
+            bool valid = capture->header.sampleCount == BURST_CAPTURE_SAMPLES && capture->header.captureId > lastId;
+            uint32_t first = sampleValue(capture->samples[0]);
+            for (int i = 1; i < BURST_CAPTURE_SAMPLES && valid; i++)
+                valid = sampleValue(capture->samples[i]) == ((first + i) & VALUE_MASK);
+            corrupted += !valid;
+
+            // Un envoi sur quatre échoue puis réussit au tour suivant
+            if (++retries % 4 == 0)
+            {
+                burstRecorderRelease(recorder, capture, BURST_UPLOAD_RETRY);
+                continue;
+            }
+            lastId = capture->header.captureId;
+            consumed++;
+            burstRecorderRelease(recorder, capture, BURST_UPLOAD_OK);
+        }
+    });
+
+    // Le producteur cède la main régulièrement, sinon le consommateur ne voit presque rien passer
+    uint32_t time = 0;
+    while (time < SAMPLE_COUNT)
+    {
+        feed(time, 64, BURST_TRIGGER_MIC);
+        std::this_thread::yield();
+    }
+    // Fin de la dernière capture en cours
+    feed(time, BURST_POSTTRIGGER_SAMPLES);
+    done.store(true);
+    consumer.join();
+
+    char message[96];
+    snprintf(message, sizeof(message), "%lu captures figées, %lu envoyées, %lu perdues faute d'emplacement",
+             (unsigned long)recorder.recorded, (unsigned long)consumed, (unsigned long)recorder.dropped);
+    TEST_MESSAGE(message);
+    TEST_ASSERT_EQUAL_UINT32(0, corrupted);
+    // Un déclenchement par délai de réarmement, dès que l'historique est plein
+    uint32_t triggers = (SAMPLE_COUNT - BURST_PRETRIGGER_SAMPLES) / BURST_REARM_MS + 1;
+    TEST_ASSERT_EQUAL_UINT32(triggers, recorder.recorded + recorder.dropped);
+    TEST_ASSERT_GREATER_THAN_UINT32(triggers / 4, recorder.recorded);
+    TEST_ASSERT_EQUAL_UINT32(recorder.recorded, consumed);
+    TEST_ASSERT_EQUAL_UINT32(consumed, recorder.uploaded);
+}
+
+// ======== CADENCE ========
+
+void test_timing_jitter_and_late_samples()
+{
+    BurstTiming timing;
+    burstTimingReset(timing);
+    int64_t start = 1000000;
+    for (int i = 0; i < 100; i++, start += BURST_PERIOD_US)
+        burstTimingUpdate(timing, start, start + 30);
+    TEST_ASSERT_EQUAL_UINT32(0, timing.jitterMaxUs);
+    TEST_ASSERT_EQUAL_UINT32(0, timing.lateSamples);
+    TEST_ASSERT_EQUAL_UINT32(30, timing.readAvgUs16 >> 4);
+    TEST_ASSERT_EQUAL_UINT32(30, timing.readMaxUs);
+
+    // Lecture bloquée 200 µs sur le verrou de l'ADC : callback suivant en retard, puis rattrapage
+    burstTimingUpdate(timing, start, start + 230);
+    start += BURST_PERIOD_US;
+    burstTimingUpdate(timing, start + 200, start + 230);
+    start += BURST_PERIOD_US;
+    burstTimingUpdate(timing, start, start + 30);
+    TEST_ASSERT_EQUAL_UINT32(230, timing.readMaxUs);
+    TEST_ASSERT_EQUAL_UINT32(200, timing.jitterMaxUs);
+    TEST_ASSERT_EQUAL_UINT32(0, timing.lateSamples);
+
+    // Callback sauté : plus de deux périodes entre deux débuts
+    start += 2500;
+    burstTimingUpdate(timing, start, start + 30);
+    TEST_ASSERT_EQUAL_UINT32(1, timing.lateSamples);
+    TEST_ASSERT_EQUAL_UINT32(1500, timing.jitterMaxUs);
+
+    // Moyenne glissante : suit une nouvelle durée de lecture
+    for (int i = 0; i < 200; i++)
+    {
+        start += BURST_PERIOD_US;
+        burstTimingUpdate(timing, start, start + 90);
+    }
+    TEST_ASSERT_EQUAL_UINT32(90, timing.readAvgUs16 >> 4);
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_detector_ignores_noise_and_drift);
+    RUN_TEST(test_detector_triggers_on_rise_per_channel);
+    RUN_TEST(test_detector_ignores_fall);
+    RUN_TEST(test_no_capture_before_history_is_full);
+    RUN_TEST(test_capture_holds_history_then_following_samples);
+    RUN_TEST(test_rearm_delay_and_busy_recording);
+    RUN_TEST(test_trigger_without_free_slot_is_dropped);
+    RUN_TEST(test_release_results);
+    RUN_TEST(test_concurrent_producer_and_consumer);
+    RUN_TEST(test_timing_jitter_and_late_samples);
+    return UNITY_END();
+}
@@ -0,0 +1,248 @@
+// Moteur d'inférence face à l'évaluation de référence de tools/model_pack.py : le blob et les
+// résultats attendus des "test_vectors" du modèle (fichier généré par model_pack.py --vectors)
+// doivent être reproduits octet par octet, pour le modèle par défaut (arbres) et pour un réseau
+// dense de test (requantification Q31, écrêtages int8, entrées hors plage et NaN). Mesure
+// ensuite le débit (inférences/s) et la RAM : statique du moteur + pile d'une inférence (pile
+// peinte d'un thread, pile à vide déduite).
+//
+//   python tools/model_pack.py tools/models/default_model.json --vectors test/data/inference_default_vectors.txt
+//   python tools/model_pack.py tools/models/dense_test_model.json --vectors test/data/inference_dense_vectors.txt
+//   pio test -e native -f test_inference -v
+#include <unity.h>
+#include <modules/inference/inference_engine.h>
+#include <modules/inference/inference_default_model.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <vector>
+
+#define VECTORS_DEFAULT_PATH "test/data/inference_default_vectors.txt"
+#define VECTORS_DENSE_PATH "test/data/inference_dense_vectors.txt"
+#define BENCHMARK_INFERENCES 2000000
+#define STACK_SIZE (64 * 1024)
+#define STACK_PAINT 0xA5
+
+struct TestVector
+{
+    float features[INFERENCE_MAX_INPUTS];
+    int8_t inputs[INFERENCE_MAX_INPUTS];
+    int32_t outputs[INFERENCE_MAX_CLASSES];
+};
+
+// Un fichier de vecteurs : blob du modèle et résultats attendus
+struct ModelVectors
+{
+    std::vector<uint8_t> blob;
+    std::vector<TestVector> vectors;
+    InferenceModel model;
+};
+
+static ModelVectors reference; // modèle par défaut (ou INFERENCE_VECTORS)
+static ModelVectors dense;
+
+// Valeurs d'une ligne "<mot-clé> v1 v2 ..." ; retourne leur nombre
+static int parseValues(char *values, float *floats, int32_t *ints, int maxCount)
+{
+    int count = 0;
+    for (char *token = strtok(values, " \n"); token != NULL && count < maxCount; token = strtok(NULL, " \n"))
+    {
+        if (floats)
+            floats[count] = strtof(token, NULL); // hexadécimal flottant : exact
+        else
+            ints[count] = strtol(token, NULL, 10);
+        count++;
+    }
+    return count;
+}
+
+static void loadVectors(ModelVectors &set, const char *path)
+{
+    std::vector<uint8_t> &blob = set.blob;
+    std::vector<TestVector> &vectors = set.vectors;
+    FILE *file = fopen(path, "r");
+    TEST_ASSERT_NOT_NULL_MESSAGE(file, path);
+
+    static char line[8192];
+    int32_t values[INFERENCE_MAX_INPUTS];
+    while (fgets(line, sizeof(line), file))
+    {
+        char *space = strchr(line, ' ');
+        if (line[0] == '#' || space == NULL)
+            continue;
+        *space = '\0';
+        char *rest = space + 1;
+
+        if (strcmp(line, "blob") == 0)
+        {
+            for (char *hex = rest; hex[0] && hex[1] && hex[0] != '\n'; hex += 2)
+            {
+                char byte[3] = {hex[0], hex[1], '\0'};
+                blob.push_back((uint8_t)strtoul(byte, NULL, 16));
+            }
+        }
+        else if (strcmp(line, "features") == 0)
+        {
+            vectors.push_back(TestVector());
+            parseValues(rest, vectors.back().features, NULL, INFERENCE_MAX_INPUTS);
+        }
+        else if (strcmp(line, "inputs") == 0 && !vectors.empty())
+        {
+            int count = parseValues(rest, NULL, values, INFERENCE_MAX_INPUTS);
+            for (int i = 0; i < count; i++)
+                vectors.back().inputs[i] = (int8_t)values[i];
+        }
+        else if (strcmp(line, "outputs") == 0 && !vectors.empty())
+        {
+            parseValues(rest, NULL, vectors.back().outputs, INFERENCE_MAX_CLASSES);
+        }
+    }
+    fclose(file);
+    TEST_ASSERT_GREATER_THAN(0, blob.size());
+    TEST_ASSERT_GREATER_THAN(0, vectors.size());
+    TEST_ASSERT_EQUAL_INT(INFERENCE_OK, inferenceModelLoad(set.model, blob.data(), blob.size()));
+}
+
+static double nowSeconds()
+{
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec * 1e-9;
+}
+
+void setUp()
+{
+    if (reference.blob.empty())
+        loadVectors(reference, getenv("INFERENCE_VECTORS") ? getenv("INFERENCE_VECTORS") : VECTORS_DEFAULT_PATH);
+    if (dense.blob.empty())
+        loadVectors(dense, VECTORS_DENSE_PATH);
+}
+
+void tearDown() {}
+
+// Le modèle intégré au firmware est bien celui que model_pack.py produit aujourd'hui
+void test_default_model_matches_pack()
+{
+    TEST_ASSERT_EQUAL_UINT32(sizeof(INFERENCE_DEFAULT_MODEL), reference.blob.size());
+    TEST_ASSERT_EQUAL_MEMORY(INFERENCE_DEFAULT_MODEL, reference.blob.data(), reference.blob.size());
+}
+
+static void checkOutputs(const ModelVectors &set)
+{
+    const InferenceModel &model = set.model;
+    const std::vector<TestVector> &vectors = set.vectors;
+    for (size_t v = 0; v < vectors.size(); v++)
+    {
+        int8_t inputs[INFERENCE_MAX_INPUTS];
+        int32_t outputs[INFERENCE_MAX_CLASSES];
+        inferenceQuantizeInputs(model, vectors[v].features, inputs);
+        inferenceRun(model, inputs, outputs);
+
+        char message[48];
+        snprintf(message, sizeof(message), "vecteur %zu", v);
+        TEST_ASSERT_EQUAL_MEMORY_MESSAGE(vectors[v].inputs, inputs, model.inputCount, message);
+        TEST_ASSERT_EQUAL_MEMORY_MESSAGE(vectors[v].outputs, outputs, model.classCount * sizeof(int32_t), message);
+    }
+}
+
+void test_outputs_match_reference()
+{
+    checkOutputs(reference);
+}
+
+void test_dense_outputs_match_reference()
+{
+    TEST_ASSERT_EQUAL_INT(INFERENCE_KIND_DENSE, dense.model.kind);
+    checkOutputs(dense);
+}
+
+void test_benchmark_inferences_per_second()
+{
+    const InferenceModel &model = reference.model;
+    const std::vector<TestVector> &vectors = reference.vectors;
+    int8_t inputs[INFERENCE_MAX_INPUTS];
+    int32_t outputs[INFERENCE_MAX_CLASSES];
+    int64_t checksum = 0;
+
+    double start = nowSeconds();
+    for (int i = 0; i < BENCHMARK_INFERENCES; i++)
+    {
+        inferenceQuantizeInputs(model, vectors[i % vectors.size()].features, inputs);
+        inferenceRun(model, inputs, outputs);
+        checksum += outputs[i % model.classCount];
+    }
+    double elapsed = nowSeconds() - start;
+
+    char message[160];
+    snprintf(message, sizeof(message), "%.0f inférences/s (%.3f us/inférence, quantification comprise), somme de contrôle %lld",
+             BENCHMARK_INFERENCES / elapsed, elapsed * 1e6 / BENCHMARK_INFERENCES, (long long)checksum);
+    TEST_MESSAGE(message);
+    TEST_ASSERT_GREATER_THAN(0, checksum);
+}
+
+// ======== PILE ========
+
+static void *idleThread(void *)
+{
+    return NULL;
+}
+
+static void *inferenceThread(void *)
+{
+    int8_t inputs[INFERENCE_MAX_INPUTS];
+    int32_t outputs[INFERENCE_MAX_CLASSES];
+    for (const ModelVectors *set : {&reference, &dense})
+    {
+        for (const TestVector &vector : set->vectors)
+        {
+            inferenceQuantizeInputs(set->model, vector.features, inputs);
+            inferenceRun(set->model, inputs, outputs);
+        }
+    }
+    return NULL;
+}
+
+// Octets de pile touchés par un thread, mesurés sur une pile peinte
+static size_t measureStack(void *(*function)(void *))
+{
+    static uint8_t stack[STACK_SIZE] __attribute__((aligned(64)));
+    memset(stack, STACK_PAINT, sizeof(stack));
+
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setstack(&attr, stack, sizeof(stack));
+    pthread_t thread;
+    TEST_ASSERT_EQUAL_INT(0, pthread_create(&thread, &attr, function, NULL));
+    pthread_join(thread, NULL);
+    pthread_attr_destroy(&attr);
+
+    size_t untouched = 0;
+    while (untouched < sizeof(stack) && stack[untouched] == STACK_PAINT)
+        untouched++;
+    return sizeof(stack) - untouched;
+}
+
+void test_ram_usage()
+{
+    size_t baseline = measureStack(idleThread);
+    size_t used = measureStack(inferenceThread);
+    size_t stack = used > baseline ? used - baseline : 0;
+
+    char message[200];
+    snprintf(message, sizeof(message), "RAM : %zu octets statiques + %zu octets de pile par inférence (hôte, %zu octets de pile à vide déduits)",
+             inferenceStaticRamSize(), stack, baseline);
+    TEST_MESSAGE(message);
+    TEST_ASSERT_LESS_THAN(STACK_SIZE / 4, stack);
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_default_model_matches_pack);
+    RUN_TEST(test_outputs_match_reference);
+    RUN_TEST(test_dense_outputs_match_reference);
+    RUN_TEST(test_benchmark_inferences_per_second);
+    RUN_TEST(test_ram_usage);
+    return UNITY_END();
+}
@@ -0,0 +1,318 @@
+// Choix de l'endpoint d'ingestion (HRW) : répartition, déplacement minimal quand la liste
+// change, bascule rapide et comptage des bascules.
+// Le même comportement est vérifié de bout en bout contre les serveurs de substitution
+// par tools/ingest_failover_check.py.
+//
+//   pio test -e native -f test_ingest
+#include <unity.h>
+#include <modules/ingest/ingest_endpoints.h>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+#define DEVICE_COUNT 3000
+
+static const char *URLS[] = {
+    "http://ingest-a.local/prout-o-metre/heartbeat",
+    "http://ingest-b.local/prout-o-metre/heartbeat",
+    "http://ingest-c.local/prout-o-metre/heartbeat",
+    "http://ingest-d.local/prout-o-metre/heartbeat",
+};
+
+static void initDevice(IngestEndpointSet &set, int device, int count)
+{
+    char deviceId[24];
+    snprintf(deviceId, sizeof(deviceId), "AABBCC%06X", device);
+    ingestInit(set, deviceId);
+    ingestSetEndpoints(set, URLS, count);
+}
+
+// Endpoint choisi par chaque device, par URL (indépendant de l'ordre de la liste)
+static std::vector<const char *> assign(int count)
+{
+    std::vector<const char *> chosen;
+    IngestEndpointSet set;
+    for (int device = 0; device < DEVICE_COUNT; device++)
+    {
+        initDevice(set, device, count);
+        chosen.push_back(URLS[ingestSelect(set, 0)]);
+    }
+    return chosen;
+}
+
+// 4 écarts-types d'une binomiale
+static void assertShare(int hits, int total, int endpoints, const char *what)
+{
+    float expected = 1.0f / endpoints;
+    float share = (float)hits / total;
+    float tolerance = 4 * sqrtf(expected * (1 - expected) / total);
+    char message[128];
+    snprintf(message, sizeof(message), "%s : %.1f %% (attendu %.1f %%)", what, 100 * share, 100 * expected);
+    TEST_MESSAGE(message);
+    TEST_ASSERT_FLOAT_WITHIN_MESSAGE(tolerance, expected, share, message);
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_spread_is_uniform()
+{
+    for (int count = 2; count <= INGEST_MAX_ENDPOINTS; count++)
+    {
+        std::vector<const char *> chosen = assign(count);
+        for (int e = 0; e < count; e++)
+        {
+            int hits = 0;
+            for (const char *url : chosen)
+                hits += url == URLS[e];
+            assertShare(hits, DEVICE_COUNT, count, URLS[e]);
+        }
+    }
+}
+
+void test_removing_endpoint_moves_only_its_devices()
+{
+    std::vector<const char *> before = assign(INGEST_MAX_ENDPOINTS);
+    std::vector<const char *> after = assign(INGEST_MAX_ENDPOINTS - 1);
+    const char *removed = URLS[INGEST_MAX_ENDPOINTS - 1];
+
+    int moved = 0, victims = 0;
+    for (int device = 0; device < DEVICE_COUNT; device++)
+    {
+        if (before[device] == removed)
+            victims++;
+        else
+            moved += before[device] != after[device];
+    }
+    TEST_ASSERT_EQUAL_INT(0, moved);
+    assertShare(victims, DEVICE_COUNT, INGEST_MAX_ENDPOINTS, "part de l'endpoint retiré");
+}
+
+void test_adding_endpoint_takes_its_share_only()
+{
+    std::vector<const char *> before = assign(INGEST_MAX_ENDPOINTS - 1);
+    std::vector<const char *> after = assign(INGEST_MAX_ENDPOINTS);
+    const char *added = URLS[INGEST_MAX_ENDPOINTS - 1];
+
+    int moved = 0, taken = 0;
+    for (int device = 0; device < DEVICE_COUNT; device++)
+    {
+        if (after[device] == added)
+            taken++;
+        else
+            moved += before[device] != after[device];
+    }
+    TEST_ASSERT_EQUAL_INT(0, moved);
+    assertShare(taken, DEVICE_COUNT, INGEST_MAX_ENDPOINTS, "part du nouvel endpoint");
+}
+
+void test_failover_after_consecutive_failures()
+{
+    IngestEndpointSet set;
+    initDevice(set, 1, 3);
+    int first = ingestSelect(set, 0);
+
+    // Bascule au INGEST_MAX_CONSECUTIVE_FAILURES-ième échec, pas avant
+    uint32_t now = 0;
+    for (int i = 1; i < INGEST_MAX_CONSECUTIVE_FAILURES; i++)
+    {
+        ingestReportFailure(set, first, false, now += 5000);
+        TEST_ASSERT_EQUAL_INT(first, ingestSelect(set, now));
+    }
+    ingestReportFailure(set, first, false, now += 5000);
+    int second = ingestSelect(set, now);
+    TEST_ASSERT_NOT_EQUAL(first, second);
+    TEST_ASSERT_EQUAL_UINT32(1, set.failovers);
+
+    // Le nouvel endpoint est conservé, sans nouvelle bascule
+    ingestReportSuccess(set, second, 100, now += 5000);
+    TEST_ASSERT_EQUAL_INT(second, ingestSelect(set, now));
+    TEST_ASSERT_EQUAL_UINT32(1, set.failovers);
+}
+
+void test_sporadic_failures_do_not_fail_over()
+{
+    IngestEndpointSet set;
+    initDevice(set, 5, 3);
+    int first = ingestSelect(set, 0);
+
+    // Deux 503 parmi des succès, isolés puis à la suite : l'endpoint reste le bon
+    const bool failed[] = {false, false, true, false, true, false, false, true, true, false};
+    uint32_t now = 0;
+    for (bool failure : failed)
+    {
+        if (failure)
+            ingestReportFailure(set, first, false, now += 5000);
+        else
+            ingestReportSuccess(set, first, 100, now += 5000);
+        TEST_ASSERT_EQUAL(INGEST_HEALTHY, ingestGetHealth(set.endpoints[first]));
+        TEST_ASSERT_EQUAL_INT(first, ingestSelect(set, now));
+    }
+    TEST_ASSERT_EQUAL_UINT32(0, set.failovers);
+
+    // Idem juste après un retour d'éviction (historique neutre)
+    for (int i = 0; i < INGEST_MAX_CONSECUTIVE_FAILURES; i++)
+        ingestReportFailure(set, first, false, now += 5000);
+    TEST_ASSERT_NOT_EQUAL(first, ingestSelect(set, now));
+    now += INGEST_COOLDOWN_MS;
+    TEST_ASSERT_EQUAL_INT(first, ingestSelect(set, now));
+    for (int i = 1; i < INGEST_MAX_CONSECUTIVE_FAILURES; i++)
+    {
+        ingestReportFailure(set, first, false, now += 5000);
+        TEST_ASSERT_EQUAL_INT(first, ingestSelect(set, now));
+    }
+}
+
+void test_sustained_failure_rate_degrades()
+{
+    IngestEndpointSet set;
+    initDevice(set, 6, 3);
+    int first = ingestSelect(set, 0);
+
+    // Un échec sur deux, jamais assez d'échecs consécutifs pour la panne : le taux d'échec
+    // finit par délaisser l'endpoint, compté comme une bascule
+    uint32_t now = 0;
+    int rounds = 0;
+    while (ingestSelect(set, now) == first && rounds++ < 20)
+    {
+        ingestReportSuccess(set, first, 100, now += 5000);
+        ingestReportFailure(set, first, false, now += 5000);
+    }
+    TEST_ASSERT_LESS_THAN(20, rounds);
+    TEST_ASSERT_EQUAL(INGEST_DEGRADED, ingestGetHealth(set.endpoints[first]));
+    TEST_ASSERT_EQUAL_UINT32(1, set.failovers);
+}
+
+void test_too_long_url_is_rejected()
+{
+    IngestEndpointSet set;
+    ingestInit(set, "AABBCC000001");
+
+    // Une URL de INGEST_URL_MAX caractères ne tient pas avec son zéro final
+    char longUrl[INGEST_URL_MAX + 1];
+    snprintf(longUrl, sizeof(longUrl), "http://ingest-e.local/%0*d", INGEST_URL_MAX - 22, 0);
+    TEST_ASSERT_EQUAL_size_t(INGEST_URL_MAX, strlen(longUrl));
+
+    const char *urls[] = {URLS[0], longUrl, URLS[1]};
+    TEST_ASSERT_TRUE(ingestSetEndpoints(set, urls, 3));
+    TEST_ASSERT_EQUAL_INT(2, set.count);
+    TEST_ASSERT_EQUAL_STRING(URLS[0], set.endpoints[0].url);
+    TEST_ASSERT_EQUAL_STRING(URLS[1], set.endpoints[1].url);
+
+    // La plus longue acceptée est gardée intacte
+    longUrl[INGEST_URL_MAX - 1] = '\0';
+    const char *fits[] = {longUrl};
+    TEST_ASSERT_TRUE(ingestSetEndpoints(set, fits, 1));
+    TEST_ASSERT_EQUAL_STRING(longUrl, set.endpoints[0].url);
+
+    // Liste sans URL valide : la liste en cours est conservée
+    longUrl[INGEST_URL_MAX - 1] = '0';
+    const char *invalid[] = {longUrl};
+    TEST_ASSERT_FALSE(ingestSetEndpoints(set, invalid, 1));
+    TEST_ASSERT_EQUAL_INT(1, set.count);
+}
+
+void test_consecutive_failures_mark_down()
+{
+    IngestEndpointSet set;
+    initDevice(set, 1, 3);
+    for (int i = 1; i < INGEST_MAX_CONSECUTIVE_FAILURES; i++)
+        ingestReportFailure(set, 0, false, 1000);
+    TEST_ASSERT_NOT_EQUAL(INGEST_DOWN, ingestGetHealth(set.endpoints[0]));
+    ingestReportFailure(set, 0, false, 1000);
+    TEST_ASSERT_EQUAL(INGEST_DOWN, ingestGetHealth(set.endpoints[0]));
+
+    for (int i = 1; i < INGEST_MAX_CONSECUTIVE_TIMEOUTS; i++)
+        ingestReportFailure(set, 1, true, 1000);
+    TEST_ASSERT_NOT_EQUAL(INGEST_DOWN, ingestGetHealth(set.endpoints[1]));
+    ingestReportFailure(set, 1, true, 1000);
+    TEST_ASSERT_EQUAL(INGEST_DOWN, ingestGetHealth(set.endpoints[1]));
+}
+
+void test_failover_after_consecutive_timeouts()
+{
+    IngestEndpointSet set;
+    initDevice(set, 2, 3);
+    int first = ingestSelect(set, 0);
+
+    uint32_t now = 0;
+    for (int i = 0; i < INGEST_MAX_CONSECUTIVE_TIMEOUTS; i++)
+        ingestReportFailure(set, first, true, now += 5000);
+    TEST_ASSERT_NOT_EQUAL(first, ingestSelect(set, now));
+    TEST_ASSERT_EQUAL_UINT32(1, set.failovers);
+}
+
+void test_cooldown_returns_to_preferred_endpoint()
+{
+    IngestEndpointSet set;
+    initDevice(set, 3, 3);
+    int first = ingestSelect(set, 0);
+    for (int i = 0; i < INGEST_MAX_CONSECUTIVE_FAILURES; i++)
+        ingestReportFailure(set, first, false, 1000);
+    int second = ingestSelect(set, 1000);
+    TEST_ASSERT_NOT_EQUAL(first, second);
+
+    TEST_ASSERT_EQUAL_INT(second, ingestSelect(set, 1000 + INGEST_COOLDOWN_MS - 1));
+    // Retour sur l'endpoint HRW préféré : ce n'est pas une bascule (le précédent n'échouait pas)
+    TEST_ASSERT_EQUAL_INT(first, ingestSelect(set, 1000 + INGEST_COOLDOWN_MS));
+    TEST_ASSERT_EQUAL_UINT32(1, set.failovers);
+}
+
+void test_reassignment_is_not_a_failover()
+{
+    // Démarrage sur la seule URL de la config, puis liste complète reçue du serveur
+    IngestEndpointSet set;
+    int reassigned = 0;
+    for (int device = 0; device < DEVICE_COUNT; device++)
+    {
+        char deviceId[24];
+        snprintf(deviceId, sizeof(deviceId), "AABBCC%06X", device);
+        ingestInit(set, deviceId);
+        ingestSetEndpoints(set, URLS, 1);
+        int first = ingestSelect(set, 0);
+        ingestReportSuccess(set, first, 100, 5000);
+
+        ingestSetEndpoints(set, URLS, INGEST_MAX_ENDPOINTS);
+        reassigned += ingestSelect(set, 5000) != first;
+        TEST_ASSERT_EQUAL_UINT32(0, set.failovers);
+
+        // Retrait de l'endpoint en cours par le serveur : pas une bascule non plus
+        const char *rest[] = {URLS[1], URLS[2], URLS[3]};
+        ingestSetEndpoints(set, rest, 3);
+        ingestSelect(set, 10000);
+        TEST_ASSERT_EQUAL_UINT32(0, set.failovers);
+    }
+    TEST_ASSERT_GREATER_THAN(DEVICE_COUNT / 2, reassigned);
+}
+
+void test_degraded_switch_is_not_a_failover()
+{
+    IngestEndpointSet set;
+    initDevice(set, 4, 3);
+    int first = ingestSelect(set, 0);
+
+    // Latence élevée : l'endpoint est délaissé sans être en panne
+    ingestReportSuccess(set, first, (uint32_t)INGEST_LATENCY_DEGRADED_MS * 2, 5000);
+    TEST_ASSERT_EQUAL(INGEST_DEGRADED, ingestGetHealth(set.endpoints[first]));
+    TEST_ASSERT_NOT_EQUAL(first, ingestSelect(set, 5000));
+    TEST_ASSERT_EQUAL_UINT32(0, set.failovers);
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_spread_is_uniform);
+    RUN_TEST(test_removing_endpoint_moves_only_its_devices);
+    RUN_TEST(test_adding_endpoint_takes_its_share_only);
+    RUN_TEST(test_failover_after_consecutive_failures);
+    RUN_TEST(test_sporadic_failures_do_not_fail_over);
+    RUN_TEST(test_sustained_failure_rate_degrades);
+    RUN_TEST(test_too_long_url_is_rejected);
+    RUN_TEST(test_consecutive_failures_mark_down);
+    RUN_TEST(test_failover_after_consecutive_timeouts);
+    RUN_TEST(test_cooldown_returns_to_preferred_endpoint);
+    RUN_TEST(test_reassignment_is_not_a_failover);
+    RUN_TEST(test_degraded_switch_is_not_a_failover);
+    return UNITY_END();
+}
@@ -0,0 +1,275 @@
+// Échantillonnage adaptatif : une trace brute (CSV t_ms,mq135,mq136,mq4,max4466, le format
+// de --replay du simulateur de flotte) est rejouée dans SensorBuffer au rythme plein, avec un
+// envoi (lecture puis vidage) toutes les FLEET_HEARTBEAT_INTERVAL ms. Le serveur reconstruit
+// chaque canal par maintien de la dernière valeur reçue ; l'écart avec le flux à rythme fixe
+// doit rester <= la bande morte du canal. Le stockage (boucle) et l'envoi (tâche heartbeat)
+// sont aussi exercés sur deux threads.
+//
+//   pio test -e native -f test_sensor_buffer
+//   SENSOR_TRACE=enregistrement.csv pio test -e native -f test_sensor_buffer
+#include <unity.h>
+#include <modules/sensors/sensor_buffer.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#define TRACE_DEFAULT_PATH "test/data/sensor_trace.csv"
+#define UPLOAD_INTERVAL 5000 // comme FLEET_HEARTBEAT_INTERVAL
+
+static const float DEADBANDS[SENSOR_CHANNEL_COUNT] = {MQ135_DEADBAND, MQ136_DEADBAND, MQ4_DEADBAND, MIC_DEADBAND};
+static const char *CHANNEL_NAMES[SENSOR_CHANNEL_COUNT] = {"mq135", "mq136", "mq4", "mic"};
+
+struct TraceSample
+{
+    uint32_t time;
+    SensorData data;
+};
+
+// Valeurs converties d'une lecture, dans l'ordre des bits CHANNEL_*
+struct Reading
+{
+    uint32_t time;
+    float values[SENSOR_CHANNEL_COUNT];
+};
+
+static std::vector<TraceSample> trace;
+
+static void loadTrace()
+{
+    const char *path = getenv("SENSOR_TRACE") ? getenv("SENSOR_TRACE") : TRACE_DEFAULT_PATH;
+    FILE *file = fopen(path, "r");
+    TEST_ASSERT_NOT_NULL(file);
+
+    char line[256];
+    while (fgets(line, sizeof(line), file))
+    {
+        unsigned time, mq135, mq136, mq4, mic;
+        if (sscanf(line, "%u,%u,%u,%u,%u", &time, &mq135, &mq136, &mq4, &mic) != 5)
+            continue; // en-tête
+        TraceSample sample;
+        sample.time = time;
+        sample.data.mq135Value = mq135;
+        sample.data.mq136Value = mq136;
+        sample.data.mq4Value = mq4;
+        sample.data.max4466Value = mic;
+        trace.push_back(sample);
+    }
+    fclose(file);
+    TEST_ASSERT_GREATER_THAN(100, trace.size());
+}
+
+static Reading convert(const TraceSample &sample, uint32_t time)
+{
+    Reading reading;
+    reading.time = time;
+    reading.values[0] = mq135ToPPM(sample.data.mq135Value);
+    reading.values[1] = mq136ToPPM(sample.data.mq136Value);
+    reading.values[2] = mq4ToPPM(sample.data.mq4Value);
+    reading.values[3] = max4466ToDecibels(sample.data.max4466Value);
+    return reading;
+}
+
+static float recordValue(const SensorRecord &record, int channel)
+{
+    const float values[SENSOR_CHANNEL_COUNT] = {record.mq135_ppm, record.mq136_ppm, record.mq4_ppm, record.mic_db};
+    return values[channel];
+}
+
+// Maintien de la dernière valeur reçue, canal par canal, comparé au flux à rythme fixe.
+// Les lectures antérieures à la première valeur reçue d'un canal comptent comme manquantes.
+static void checkReconstruction(const std::vector<Reading> &readings, const std::vector<SensorRecord> &received)
+{
+    for (int c = 0; c < SENSOR_CHANNEL_COUNT; c++)
+    {
+        size_t next = 0;
+        bool held = false;
+        float heldValue = 0;
+        float maxError = 0;
+        uint32_t missing = 0;
+
+        for (const Reading &reading : readings)
+        {
+            while (next < received.size() && received[next].timestamp <= reading.time)
+            {
+                if (received[next].channels & (1 << c))
+                {
+                    held = true;
+                    heldValue = recordValue(received[next], c);
+                }
+                next++;
+            }
+            if (!held)
+                missing++;
+            else
+                maxError = max(maxError, fabsf(heldValue - reading.values[c]));
+        }
+
+        char message[128];
+        snprintf(message, sizeof(message), "%s : erreur max %.4f, bande morte %.4f, %u lectures sans valeur",
+                 CHANNEL_NAMES[c], maxError, DEADBANDS[c], missing);
+        TEST_MESSAGE(message);
+        TEST_ASSERT_EQUAL_UINT32_MESSAGE(0, missing, message);
+        TEST_ASSERT_LESS_OR_EQUAL_MESSAGE(DEADBANDS[c], maxError, message);
+    }
+}
+
+// Rejoue la trace à ses propres dates ; uploadInterval = 0 : aucun envoi
+static void replay(SensorBuffer &buffer, uint32_t uploadInterval,
+                   std::vector<Reading> &readings, std::vector<SensorRecord> &received)
+{
+    uint32_t origin = trace.front().time;
+    uint32_t lastUpload = 0;
+    buffer.clear();
+
+    for (const TraceSample &sample : trace)
+    {
+        uint32_t now = sample.time - origin;
+        halSetMillis(now);
+        buffer.addSensorData(sample.data);
+        readings.push_back(convert(sample, now));
+
+        if (uploadInterval > 0 && now - lastUpload >= uploadInterval)
+        {
+            for (int i = 0; i < buffer.getSize(); i++)
+                received.push_back(buffer.getRecord(i));
+            buffer.clear();
+            lastUpload = now;
+        }
+    }
+}
+
+void setUp()
+{
+    if (trace.empty())
+        loadTrace();
+}
+
+void tearDown() {}
+
+void test_reconstruction_within_deadband()
+{
+    static SensorBuffer buffer;
+    std::vector<Reading> readings;
+    std::vector<SensorRecord> received;
+    replay(buffer, UPLOAD_INTERVAL, readings, received);
+
+    char message[96];
+    snprintf(message, sizeof(message), "%zu lectures, %zu enregistrements envoyés (%.1f %%)",
+             readings.size(), received.size(), 100.0 * received.size() / readings.size());
+    TEST_MESSAGE(message);
+    checkReconstruction(readings, received);
+}
+
+// Régime établi : chaque envoi doit suffire à reconstruire tous les canaux, même stables
+void test_every_upload_carries_every_channel()
+{
+    static SensorBuffer buffer;
+    TraceSample flat = trace.front();
+    uint32_t lastUpload = 0;
+    buffer.clear();
+
+    for (uint32_t now = 0; now < 600000; now += SENSOR_SAMPLING_INTERVAL)
+    {
+        halSetMillis(now);
+        buffer.addSensorData(flat.data);
+        if (now - lastUpload >= 60000)
+        {
+            uint8_t channels = 0;
+            for (int i = 0; i < buffer.getSize(); i++)
+                channels |= buffer.getRecord(i).channels;
+            TEST_ASSERT_EQUAL_INT(CHANNEL_ALL, channels & CHANNEL_ALL);
+            buffer.clear();
+            lastUpload = now;
+        }
+    }
+}
+
+// Envois interrompus : le buffer déborde, mais ce qu'il contient reste reconstructible seul
+void test_overwrite_keeps_every_channel()
+{
+    static SensorBuffer buffer;
+    std::vector<Reading> readings;
+    std::vector<SensorRecord> received;
+    replay(buffer, 0, readings, received);
+    TEST_ASSERT_GREATER_THAN_UINT32(0, buffer.getOverwrittenCount());
+
+    for (int i = 0; i < buffer.getSize(); i++)
+        received.push_back(buffer.getRecord(i));
+
+    // Chaque canal doit rester présent dans le buffer malgré l'écrasement
+    uint8_t channels = 0;
+    for (const SensorRecord &record : received)
+        channels |= record.channels;
+    TEST_ASSERT_EQUAL_INT(CHANNEL_ALL, channels & CHANNEL_ALL);
+
+    // Lectures reconstructibles : à partir de la première valeur conservée de chaque canal
+    uint32_t from = received.front().timestamp;
+    uint32_t reconstructibleFrom = from;
+    for (int c = 0; c < SENSOR_CHANNEL_COUNT; c++)
+    {
+        for (const SensorRecord &record : received)
+        {
+            if (record.channels & (1 << c))
+            {
+                reconstructibleFrom = max(reconstructibleFrom, record.timestamp);
+                break;
+            }
+        }
+    }
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32(from + ADAPTIVE_SLOW_INTERVAL, reconstructibleFrom);
+
+    std::vector<Reading> checked;
+    for (const Reading &reading : readings)
+    {
+        if (reading.time >= reconstructibleFrom)
+            checked.push_back(reading);
+    }
+    checkReconstruction(checked, received);
+}
+
+// Boucle et tâche heartbeat sur deux threads : chaque enregistrement stocké est envoyé,
+// écrasé ou encore dans le buffer, jamais perdu entre la lecture et le vidage
+void test_concurrent_store_and_upload()
+{
+    static SensorBuffer buffer;
+    const int READING_COUNT = 200000;
+    std::atomic<bool> done(false);
+    uint32_t uploaded = 0;
+    buffer.clear();
+    uint32_t storedBefore = buffer.getStoredCount();
+    uint32_t overwrittenBefore = buffer.getOverwrittenCount();
+
+    std::thread uploader([&]()
+    {
+        while (!done.load())
+        {
+            JsonDocument doc;
+            uploaded += buffer.moveToJson(doc);
+            std::this_thread::yield();
+        }
+    });
+
+    // Chaque lecture sort de la bande morte de tous les canaux : toutes sont stockées
+    for (int i = 0; i < READING_COUNT; i++)
+    {
+        float step = (i % 2) ? 100.0f : 0.0f;
+        buffer.addSensorData(step, step, step, step);
+    }
+    done.store(true);
+    uploader.join();
+
+    uint32_t stored = buffer.getStoredCount() - storedBefore;
+    uint32_t overwritten = buffer.getOverwrittenCount() - overwrittenBefore;
+    TEST_ASSERT_EQUAL_UINT32(READING_COUNT, stored);
+    TEST_ASSERT_EQUAL_UINT32(stored, uploaded + overwritten + buffer.getSize());
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_reconstruction_within_deadband);
+    RUN_TEST(test_every_upload_carries_every_channel);
+    RUN_TEST(test_overwrite_keeps_every_channel);
+    RUN_TEST(test_concurrent_store_and_upload);
+    return UNITY_END();
+}
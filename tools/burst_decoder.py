@@ -0,0 +1,75 @@
+"""
+Décodage des captures rapides du firmware (src/modules/burst/), envoyées en binaire
+sur <URL du heartbeat>/capture : en-tête de 24 octets puis échantillons ADC bruts
+(mq135, mq136, mq4 en uint16 little-endian) à sampleRate Hz.
+
+Sortie CSV : temps relatif au déclenchement (ms), puis les trois canaux.
+
+Usage :
+    python tools/burst_decoder.py capture.bin                # résumé
+    python tools/burst_decoder.py capture.bin -o capture.csv
+"""
+import argparse
+import struct
+
+HEADER = struct.Struct("<IBBBBHHHHII")
+MAGIC = 0x50414342
+TRIGGERS = {0: "mq135", 1: "mq136", 2: "mq4", 3: "micro"}
+CHANNELS = ("mq135", "mq136", "mq4")
+
+
+def decode(data):
+    if len(data) < HEADER.size:
+        raise ValueError("capture tronquée (%d octets)" % len(data))
+    (magic, version, trigger, channels, _, sample_rate, pre_trigger, count, _,
+     trigger_time, capture_id) = HEADER.unpack_from(data)
+    if magic != MAGIC:
+        raise ValueError("magic invalide 0x%08X" % magic)
+    if version != 1 or channels != len(CHANNELS):
+        raise ValueError("version %d / %d canaux non supportés" % (version, channels))
+
+    expected = HEADER.size + count * channels * 2
+    if len(data) < expected:
+        raise ValueError("capture tronquée : %d octets sur %d" % (len(data), expected))
+
+    samples = list(struct.iter_unpack("<HHH", data[HEADER.size:expected]))
+    header = {
+        "capture_id": capture_id,
+        "trigger": TRIGGERS.get(trigger, str(trigger)),
+        "trigger_time_ms": trigger_time,
+        "sample_rate": sample_rate,
+        "pre_trigger": pre_trigger,
+        "count": count,
+    }
+    return header, samples
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Décodage d'une capture rapide du firmware")
+    parser.add_argument("capture", help="fichier binaire reçu sur /capture")
+    parser.add_argument("-o", "--output", help="fichier CSV à écrire")
+    args = parser.parse_args()
+
+    with open(args.capture, "rb") as f:
+        header, samples = decode(f.read())
+
+    period_ms = 1000.0 / header["sample_rate"]
+    print("Capture %(capture_id)d : déclenchement %(trigger)s à %(trigger_time_ms)d ms, "
+          "%(count)d échantillons à %(sample_rate)d Hz dont %(pre_trigger)d avant" % header)
+    for c, name in enumerate(CHANNELS):
+        before = [s[c] for s in samples[:header["pre_trigger"]]] or [0]
+        after = [s[c] for s in samples[header["pre_trigger"]:]] or [0]
+        print("  %-6s avant : moy %.1f | après : min %d max %d" % (
+            name, sum(before) / len(before), min(after), max(after)))
+
+    if args.output:
+        with open(args.output, "w") as f:
+            f.write("t_ms,%s\n" % ",".join(CHANNELS))
+            for i, sample in enumerate(samples):
+                t = (i - header["pre_trigger"] + 1) * period_ms
+                f.write("%.1f,%d,%d,%d\n" % ((t,) + sample))
+        print("[INFO] %d lignes écrites dans %s" % (len(samples), args.output))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,567 @@
+#include "fleet_device.h"
+#include <modules/sensors/sensors_manager.h>
+#include <modules/heartbeat/heartbeat_protocol.h>
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <strings.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <unordered_map>
+
+// Codes d'erreur de HTTPClient, pour que la santé des endpoints soit traitée comme sur le device
+#define FLEET_ERROR_CONNECTION_REFUSED -1
+#define FLEET_ERROR_CONNECTION_LOST -5
+#define FLEET_ERROR_READ_TIMEOUT -11
+
+// ======== ALÉATOIRE ========
+
+static uint32_t nextRandom(uint32_t &state)
+{
+    // xorshift32 : assez bon pour des signaux synthétiques, sans état partagé entre devices
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+static float randomUnit(uint32_t &state)
+{
+    return (nextRandom(state) >> 8) * (1.0f / 16777216.0f);
+}
+
+// ======== URL ET ADRESSES ========
+
+static bool parseHttpUrl(const char *url, std::string &host, uint16_t &port, std::string &path)
+{
+    // Seul http:// est simulé : la reprise de session TLS est mesurée à part (tools/tls_test_server.py)
+    if (strncmp(url, "http://", 7) != 0)
+        return false;
+
+    const char *hostStart = url + 7;
+    const char *hostEnd = hostStart + strcspn(hostStart, ":/");
+    host.assign(hostStart, hostEnd - hostStart);
+    port = *hostEnd == ':' ? atoi(hostEnd + 1) : 80;
+    const char *pathStart = strchr(hostStart, '/');
+    path = pathStart ? pathStart : "/";
+    return !host.empty() && port > 0;
+}
+
+// Résolution faite une seule fois par hôte (bloquante, hors du chemin chaud)
+static bool resolveHost(const std::string &host, uint16_t port, sockaddr_in &address)
+{
+    static std::unordered_map<std::string, in_addr> cache;
+    auto it = cache.find(host);
+    if (it == cache.end())
+    {
+        addrinfo hints = {};
+        hints.ai_family = AF_INET;
+        hints.ai_socktype = SOCK_STREAM;
+        addrinfo *result = NULL;
+        if (getaddrinfo(host.c_str(), NULL, &hints, &result) != 0 || result == NULL)
+            return false;
+        it = cache.emplace(host, ((sockaddr_in *)result->ai_addr)->sin_addr).first;
+        freeaddrinfo(result);
+    }
+
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_port = htons(port);
+    address.sin_addr = it->second;
+    return true;
+}
+
+// ======== SIGNAUX ========
+
+static bool inOutage(const FleetContext &context, const FleetDevice &device, uint32_t now)
+{
+    for (const FleetOutage &outage : context.config.outages)
+    {
+        if (device.outageDraw < outage.fraction && now >= outage.start && now - outage.start < outage.duration)
+            return true;
+    }
+    return false;
+}
+
+static uint16_t clampAdc(float value)
+{
+    return (uint16_t)std::min(4095.0f, std::max(0.0f, value));
+}
+
+static SensorData readSensors(FleetContext &context, FleetDevice &device, uint32_t now)
+{
+    const std::vector<FleetReplaySample> &replay = context.config.replay;
+    if (!replay.empty())
+    {
+        // Relecture en boucle, chaque device à son propre décalage
+        uint32_t length = replay.back().time + SENSOR_SAMPLING_INTERVAL;
+        uint32_t t = (now - device.bootAt + device.replayOffset) % length;
+        auto it = std::upper_bound(replay.begin(), replay.end(), t,
+                                   [](uint32_t time, const FleetReplaySample &sample)
+                                   { return time < sample.time; });
+        return it == replay.begin() ? replay.front().data : (it - 1)->data;
+    }
+
+    // Événements poissonniens : montée en 2 s puis décroissance exponentielle (tau 20 s)
+    float eventProbability = context.config.eventsPerHour * SENSOR_SAMPLING_INTERVAL / 3600000.0f;
+    if (device.eventAmplitude == 0 && randomUnit(device.rng) < eventProbability)
+    {
+        device.eventStart = now;
+        device.eventAmplitude = 300.0f + 600.0f * randomUnit(device.rng);
+    }
+    float envelope = 0;
+    if (device.eventAmplitude > 0)
+    {
+        uint32_t t = now - device.eventStart;
+        envelope = t < 2000 ? t / 2000.0f : expf(-(t - 2000.0f) / 20000.0f);
+        if (t > 2000 && envelope < 0.01f)
+            device.eventAmplitude = 0;
+    }
+
+    // Dérive lente (période de 10 min) et bruit d'ADC
+    float drift = 20.0f * sinf(now * (2.0f * (float)M_PI / 600000.0f) + device.id);
+    float noise[4];
+    for (int c = 0; c < 4; c++)
+        noise[c] = (randomUnit(device.rng) + randomUnit(device.rng) - 1.0f) * context.config.noise;
+
+    float event = device.eventAmplitude * envelope;
+    SensorData data;
+    data.mq135Value = clampAdc(device.baseline[0] + drift + noise[0] + 0.3f * event);
+    data.mq136Value = clampAdc(device.baseline[1] + drift + noise[1] + event);
+    data.mq4Value = clampAdc(device.baseline[2] + drift + noise[2] + 0.6f * event);
+    data.max4466Value = clampAdc(device.baseline[3] + 10.0f * noise[3] + (envelope > 0.5f ? event : 0.0f));
+    return data;
+}
+
+static void sample(FleetContext &context, FleetDevice &device, uint32_t now)
+{
+    uint32_t stored = device.buffer.getStoredCount();
+    uint32_t overwritten = device.buffer.getOverwrittenCount();
+
+    halSetMillis(now);
+    device.buffer.addSensorData(readSensors(context, device, now));
+
+    context.stats.readings++;
+    context.stats.recordsStored += device.buffer.getStoredCount() - stored;
+    uint32_t lost = device.buffer.getOverwrittenCount() - overwritten;
+    if (device.debugEnabled)
+        context.stats.recordsOverwritten += lost;
+    else
+        context.stats.recordsNotRequested += lost;
+}
+
+// ======== CONNEXION ========
+
+static void closeConnection(FleetDevice &device)
+{
+    if (device.fd >= 0)
+        close(device.fd); // retire aussi la socket d'epoll
+    device.fd = -1;
+    device.conn = FLEET_CONN_CLOSED;
+    device.in.clear();
+}
+
+static void watch(FleetContext &context, FleetDevice &device, uint32_t events)
+{
+    epoll_event event = {};
+    event.events = events;
+    event.data.ptr = &device;
+    epoll_ctl(context.epollFd, EPOLL_CTL_MOD, device.fd, &event);
+}
+
+// Fin d'un heartbeat : mêmes règles que heartbeat_manager.cpp
+static void finishRequest(FleetContext &context, FleetDevice &device, int httpCode, bool timeout, uint32_t now)
+{
+    uint32_t latency = now - device.requestStart;
+    FleetStats &stats = context.stats;
+
+    if (httpCode <= 0 || httpCode >= 500 || httpCode == 429)
+    {
+        ingestReportFailure(device.endpoints, device.endpointIndex, timeout, now);
+        closeConnection(device);
+    }
+    else
+    {
+        ingestReportSuccess(device.endpoints, device.endpointIndex, latency, now);
+        stats.latencyHistogram[std::min<uint32_t>(latency, FLEET_LATENCY_BUCKETS - 1)]++;
+    }
+
+    if (httpCode == 200)
+    {
+        stats.responsesOk++;
+        stats.recordsDelivered += device.recordsInFlight;
+
+        size_t headerEnd = device.in.find("\r\n\r\n");
+        const char *body = device.in.c_str() + headerEnd + 4;
+        JsonDocument doc;
+        HeartbeatResponse commands;
+        if (heartbeatParseResponse(doc, body, device.in.size() - headerEnd - 4, commands))
+        {
+            device.debugEnabled = commands.debug;
+            if (commands.ingestEndpointCount > 0)
+                ingestSetEndpoints(device.endpoints, commands.ingestEndpoints, commands.ingestEndpointCount);
+        }
+    }
+    else
+    {
+        stats.failures++;
+        if (httpCode > 0)
+            stats.responsesError++;
+        stats.recordsLostInFlight += device.recordsInFlight;
+    }
+
+    device.recordsInFlight = 0;
+    device.in.clear();
+    device.nextHeartbeat = now + FLEET_HEARTBEAT_INTERVAL;
+}
+
+static void sendPending(FleetContext &context, FleetDevice &device, uint32_t now)
+{
+    while (device.outSent < device.out.size())
+    {
+        ssize_t sent = send(device.fd, device.out.data() + device.outSent, device.out.size() - device.outSent, MSG_NOSIGNAL);
+        if (sent < 0)
+        {
+            if (errno == EAGAIN || errno == EWOULDBLOCK)
+                return;
+            context.stats.connectFailures++;
+            finishRequest(context, device, FLEET_ERROR_CONNECTION_LOST, false, now);
+            return;
+        }
+        device.outSent += sent;
+        context.stats.bytesSent += sent;
+    }
+
+    device.conn = FLEET_CONN_RECEIVING;
+    watch(context, device, EPOLLIN | EPOLLRDHUP);
+}
+
+static void openConnection(FleetContext &context, FleetDevice &device, const sockaddr_in &address, uint32_t now)
+{
+    device.fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (device.fd < 0)
+    {
+        context.stats.connectFailures++;
+        finishRequest(context, device, FLEET_ERROR_CONNECTION_REFUSED, false, now);
+        return;
+    }
+    int one = 1;
+    setsockopt(device.fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+    epoll_event event = {};
+    event.events = EPOLLOUT;
+    event.data.ptr = &device;
+    epoll_ctl(context.epollFd, EPOLL_CTL_ADD, device.fd, &event);
+
+    device.conn = FLEET_CONN_CONNECTING;
+    if (connect(device.fd, (const sockaddr *)&address, sizeof(address)) < 0 && errno != EINPROGRESS)
+    {
+        context.stats.connectFailures++;
+        finishRequest(context, device, FLEET_ERROR_CONNECTION_REFUSED, false, now);
+    }
+}
+
+// ======== HEARTBEAT ========
+
+static void startHeartbeat(FleetContext &context, FleetDevice &device, uint32_t now)
+{
+    FleetStats &stats = context.stats;
+
+    // Choisir l'endpoint ; en changer ferme la connexion gardée ouverte
+    uint32_t failoversBefore = device.endpoints.failovers;
+    device.endpointIndex = ingestSelect(device.endpoints, now);
+    stats.failovers += device.endpoints.failovers - failoversBefore;
+    if (device.endpointIndex < 0)
+    {
+        device.nextHeartbeat = now + FLEET_HEARTBEAT_INTERVAL;
+        return;
+    }
+    const char *url = device.endpoints.endpoints[device.endpointIndex].url;
+    if (strcmp(device.activeUrl, url) != 0)
+    {
+        closeConnection(device);
+        strncpy(device.activeUrl, url, sizeof(device.activeUrl) - 1);
+    }
+
+    std::string host, path;
+    uint16_t port;
+    sockaddr_in address;
+    if (!parseHttpUrl(device.activeUrl, host, port, path) || !resolveHost(host, port, address))
+    {
+        ingestReportFailure(device.endpoints, device.endpointIndex, false, now);
+        device.activeUrl[0] = '\0';
+        device.nextHeartbeat = now + FLEET_HEARTBEAT_INTERVAL;
+        return;
+    }
+
+    // Payload construit par le code du firmware
+    JsonDocument doc;
+    device.recordsInFlight = heartbeatBuildPayload(doc, device.uuid, device.debugEnabled ? &device.buffer : NULL);
+    std::string body;
+    serializeJson(doc, body);
+
+    // En-têtes tels qu'envoyés par HTTPClient (setReuse(true))
+    char headers[512];
+    snprintf(headers, sizeof(headers),
+             "POST %s HTTP/1.1\r\n"
+             "Host: %s:%u\r\n"
+             "User-Agent: ProutOMetre-ESP32\r\n"
+             "Connection: keep-alive\r\n"
+             "Accept-Encoding: identity;q=1,chunked;q=0.1,*;q=0\r\n"
+             "Content-Type: application/json\r\n"
+             "Content-Length: %zu\r\n\r\n",
+             path.c_str(), host.c_str(), port, body.size());
+    device.out = headers;
+    device.out += body;
+    device.outSent = 0;
+    device.in.clear();
+    device.requestStart = now;
+    device.deadline = now + FLEET_HTTP_TIMEOUT;
+    stats.requests++;
+
+    if (device.conn == FLEET_CONN_IDLE)
+    {
+        device.conn = FLEET_CONN_SENDING;
+        watch(context, device, EPOLLOUT);
+        sendPending(context, device, now);
+    }
+    else
+    {
+        openConnection(context, device, address, now);
+    }
+}
+
+// Réponse complète (en-têtes + Content-Length octets) ?
+static bool responseComplete(const std::string &in, int &httpCode, bool &keepAlive)
+{
+    size_t headerEnd = in.find("\r\n\r\n");
+    if (headerEnd == std::string::npos || in.compare(0, 5, "HTTP/") != 0)
+        return false;
+
+    httpCode = atoi(in.c_str() + in.find(' ') + 1);
+    size_t contentLength = 0;
+    keepAlive = true;
+    size_t line = in.find("\r\n") + 2;
+    while (line < headerEnd)
+    {
+        size_t next = in.find("\r\n", line);
+        std::string header = in.substr(line, next - line);
+        if (strncasecmp(header.c_str(), "Content-Length:", 15) == 0)
+            contentLength = strtoul(header.c_str() + 15, NULL, 10);
+        else if (strncasecmp(header.c_str(), "Connection:", 11) == 0 && strcasestr(header.c_str(), "close") != NULL)
+            keepAlive = false;
+        line = next + 2;
+    }
+    return in.size() >= headerEnd + 4 + contentLength;
+}
+
+// ======== API ========
+
+void fleetDeviceInit(FleetContext &context, FleetDevice &device, int id)
+{
+    device.id = id;
+    device.rng = (context.config.seed * 2654435761u) ^ (id * 2246822519u) ^ 0x9E3779B9u;
+    if (device.rng == 0)
+        device.rng = 1;
+
+    // UUID v4 comme generateUUIDv4(), tiré du générateur du device
+    uint8_t uuid[16];
+    for (int i = 0; i < 16; i++)
+        uuid[i] = nextRandom(device.rng) & 0xFF;
+    uuid[6] = (uuid[6] & 0x0F) | 0x40;
+    uuid[8] = (uuid[8] & 0x3F) | 0x80;
+    snprintf(device.uuid, sizeof(device.uuid),
+             "%02X%02X%02X%02X-%02X%02X-%02X%02X-%02X%02X-%02X%02X%02X%02X%02X%02X",
+             uuid[0], uuid[1], uuid[2], uuid[3], uuid[4], uuid[5], uuid[6], uuid[7],
+             uuid[8], uuid[9], uuid[10], uuid[11], uuid[12], uuid[13], uuid[14], uuid[15]);
+
+    device.bootAt = (uint32_t)(randomUnit(device.rng) * context.config.bootSpread);
+    device.booted = false;
+    device.outageDraw = randomUnit(device.rng);
+    device.replayOffset = nextRandom(device.rng);
+    device.eventAmplitude = 0;
+    device.baseline[0] = 1400.0f + 400.0f * randomUnit(device.rng);
+    device.baseline[1] = 900.0f + 300.0f * randomUnit(device.rng);
+    device.baseline[2] = 1200.0f + 400.0f * randomUnit(device.rng);
+    device.baseline[3] = 2048.0f;
+
+    device.fd = -1;
+    device.conn = FLEET_CONN_CLOSED;
+    device.activeUrl[0] = '\0';
+    device.recordsInFlight = 0;
+    device.debugEnabled = false;
+}
+
+void fleetDeviceTick(FleetContext &context, FleetDevice &device, uint32_t now)
+{
+    if (now < device.bootAt)
+        return;
+
+    if (!device.booted)
+    {
+        // Fin de setup() : loop principale et tâche heartbeat démarrent
+        if (now - device.bootAt < FLEET_BOOT_DURATION)
+            return;
+        uint32_t start = device.bootAt + FLEET_BOOT_DURATION;
+        const char *urls[INGEST_MAX_ENDPOINTS];
+        int count = std::min<int>(context.config.urls.size(), INGEST_MAX_ENDPOINTS);
+        for (int i = 0; i < count; i++)
+            urls[i] = context.config.urls[i].c_str();
+
+        device.booted = true;
+        device.buffer.clear();
+        wifiConnectStart(device.wifi);
+        device.associated = false;
+        device.linkUp = false;
+        device.nextWifiStep = start;
+        device.nextSample = start;
+        device.nextHeartbeat = start + FLEET_HEARTBEAT_INTERVAL;
+        ingestInit(device.endpoints, device.uuid);
+        ingestSetEndpoints(device.endpoints, urls, count);
+    }
+
+    // Wi-Fi : l'AP disparaît pendant une coupure scriptée
+    bool outage = inOutage(context, device, now);
+    if (outage && device.associated)
+    {
+        device.associated = false;
+        if (device.conn == FLEET_CONN_IDLE)
+            closeConnection(device);
+        else if (device.conn != FLEET_CONN_CLOSED && device.conn != FLEET_CONN_LOST)
+        {
+            closeConnection(device);
+            device.conn = FLEET_CONN_LOST;
+        }
+    }
+    if (now >= device.nextWifiStep)
+    {
+        device.nextWifiStep = now + FLEET_LOOP_INTERVAL;
+        device.linkUp = device.associated && now >= device.linkReadyAt && !outage;
+        switch (wifiConnectStep(device.wifi, device.linkUp, now, 1))
+        {
+        case WIFI_ACTION_BEGIN:
+            // Association et DHCP : entre 0,5 et 2,5 s
+            device.associated = true;
+            device.linkReadyAt = now + 500 + (uint32_t)(2000 * randomUnit(device.rng));
+            context.stats.wifiReconnects++;
+            break;
+        case WIFI_ACTION_FAILED:
+            device.associated = false;
+            break;
+        default:
+            break;
+        }
+    }
+
+    // Lectures au rythme de sensorBufferProcess()
+    if (now - device.nextSample > FLEET_MAX_CATCHUP && (int32_t)(now - device.nextSample) > 0)
+    {
+        uint32_t skipped = (now - device.nextSample) / SENSOR_SAMPLING_INTERVAL;
+        context.stats.readingsSkipped += skipped;
+        device.nextSample += skipped * SENSOR_SAMPLING_INTERVAL;
+    }
+    while ((int32_t)(now - device.nextSample) >= 0)
+    {
+        sample(context, device, device.nextSample);
+        device.nextSample += SENSOR_SAMPLING_INTERVAL;
+    }
+
+    // Requête en cours : timeout de connexion ou de réponse
+    bool busy = device.conn == FLEET_CONN_CONNECTING || device.conn == FLEET_CONN_SENDING ||
+                device.conn == FLEET_CONN_RECEIVING || device.conn == FLEET_CONN_LOST;
+    if (busy)
+    {
+        if ((int32_t)(now - device.deadline) >= 0)
+        {
+            context.stats.timeouts++;
+            if (device.conn == FLEET_CONN_CONNECTING)
+            {
+                context.stats.connectFailures++;
+                finishRequest(context, device, FLEET_ERROR_CONNECTION_REFUSED, true, now);
+            }
+            else
+            {
+                finishRequest(context, device, FLEET_ERROR_READ_TIMEOUT, true, now);
+            }
+        }
+        return;
+    }
+
+    // Heartbeat : la tâche attend son intervalle puis vérifie le Wi-Fi
+    if ((int32_t)(now - device.nextHeartbeat) >= 0)
+    {
+        if (device.linkUp)
+            startHeartbeat(context, device, now);
+        else
+            device.nextHeartbeat = now + FLEET_HEARTBEAT_INTERVAL;
+    }
+}
+
+void fleetDeviceOnIo(FleetContext &context, FleetDevice &device, uint32_t events, uint32_t now)
+{
+    switch (device.conn)
+    {
+    case FLEET_CONN_CONNECTING:
+    {
+        int error = 0;
+        socklen_t length = sizeof(error);
+        getsockopt(device.fd, SOL_SOCKET, SO_ERROR, &error, &length);
+        if (error != 0 || (events & (EPOLLERR | EPOLLHUP)))
+        {
+            context.stats.connectFailures++;
+            finishRequest(context, device, FLEET_ERROR_CONNECTION_REFUSED, false, now);
+            return;
+        }
+        context.stats.connectionsOpened++;
+        device.conn = FLEET_CONN_SENDING;
+        // La réponse doit arriver dans le timeout à partir de la connexion établie
+        device.deadline = now + FLEET_HTTP_TIMEOUT;
+        sendPending(context, device, now);
+        return;
+    }
+    case FLEET_CONN_SENDING:
+        sendPending(context, device, now);
+        return;
+    case FLEET_CONN_RECEIVING:
+    case FLEET_CONN_IDLE:
+        break;
+    default:
+        return;
+    }
+
+    char chunk[4096];
+    while (true)
+    {
+        ssize_t received = recv(device.fd, chunk, sizeof(chunk), 0);
+        if (received > 0)
+        {
+            context.stats.bytesReceived += received;
+            if (device.conn == FLEET_CONN_RECEIVING)
+                device.in.append(chunk, received);
+            continue;
+        }
+        if (received < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+            break;
+
+        // Fermeture par le serveur : normale au repos, échec en pleine requête
+        if (device.conn == FLEET_CONN_RECEIVING)
+            finishRequest(context, device, FLEET_ERROR_CONNECTION_LOST, false, now);
+        else
+            closeConnection(device);
+        return;
+    }
+
+    int httpCode;
+    bool keepAlive;
+    if (device.conn == FLEET_CONN_RECEIVING && responseComplete(device.in, httpCode, keepAlive))
+    {
+        device.conn = FLEET_CONN_IDLE;
+        watch(context, device, EPOLLIN | EPOLLRDHUP);
+        finishRequest(context, device, httpCode, false, now);
+        if (!keepAlive)
+            closeConnection(device);
+    }
+}
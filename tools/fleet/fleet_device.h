@@ -0,0 +1,135 @@
+#pragma once
+#include <modules/sensors/sensor_buffer.h>
+#include <modules/wifi/wifi_connect.h>
+#include <modules/ingest/ingest_endpoints.h>
+#include <string>
+#include <vector>
+
+// ======== CONFIGURATION ========
+// Mêmes valeurs que le firmware (heartbeat_manager.cpp, main.cpp)
+#define FLEET_HEARTBEAT_INTERVAL 5000 // Attente entre deux heartbeats (ms)
+#define FLEET_HTTP_TIMEOUT 3000       // Timeout de connexion puis de réponse (ms)
+#define FLEET_LOOP_INTERVAL 50        // Période de la loop principale (ms)
+#define FLEET_LATENCY_BUCKETS 10000   // Histogramme des latences, 1 ms par case
+#define FLEET_MAX_CATCHUP 1000        // Retard max rattrapé par un device avant de sauter des lectures (ms)
+#define FLEET_BOOT_DURATION 7500      // setup() : calibration des capteurs avant la première lecture (ms)
+
+// Coupure Wi-Fi scriptée : une fraction des devices perd l'AP pendant duration ms
+struct FleetOutage
+{
+    uint32_t start;
+    uint32_t duration;
+    float fraction;
+};
+
+// Lecture brute rejouée (valeurs ADC), voir --replay
+struct FleetReplaySample
+{
+    uint32_t time;
+    SensorData data;
+};
+
+struct FleetConfig
+{
+    int deviceCount = 100;
+    uint32_t duration = 300000;    // durée virtuelle (ms)
+    float speed = 1.0f;            // ms virtuelles par ms réelle
+    uint32_t bootSpread = 30000;   // démarrages étalés sur cette durée (ms)
+    uint32_t reportInterval = 10000; // période des rapports (ms réelles)
+    uint32_t seed = 1;
+    float noise = 4.0f;            // bruit ADC des capteurs de gaz (pas d'ADC)
+    float eventsPerHour = 2.0f;    // événements synthétiques par device
+    std::vector<std::string> urls;
+    std::vector<FleetOutage> outages;
+    std::vector<FleetReplaySample> replay;
+};
+
+// Compteurs cumulés de la flotte
+struct FleetStats
+{
+    uint64_t requests;
+    uint64_t responsesOk;        // HTTP 200
+    uint64_t responsesError;     // autre code HTTP
+    uint64_t failures;           // requêtes sans réponse 200 (transport ou code HTTP)
+    uint64_t connectFailures;
+    uint64_t timeouts;
+    uint64_t connectionsOpened;
+    uint64_t bytesSent;          // payload TCP, en-têtes HTTP compris
+    uint64_t bytesReceived;
+    uint64_t readings;
+    uint64_t recordsStored;
+    uint64_t recordsDelivered;
+    uint64_t recordsLostInFlight; // envoyés dans une requête échouée (le buffer est vidé avant)
+    uint64_t recordsOverwritten;  // écrasés dans le buffer avant d'être envoyés
+    uint64_t recordsNotRequested; // écrasés alors que le serveur n'a pas demandé les échantillons (debug)
+    uint64_t readingsSkipped;     // lectures sautées parce que le simulateur a pris du retard
+    uint64_t failovers;
+    uint64_t wifiReconnects;
+    uint32_t latencyHistogram[FLEET_LATENCY_BUCKETS];
+};
+
+struct FleetContext
+{
+    FleetConfig config;
+    FleetStats stats;
+    int epollFd;
+};
+
+enum FleetConnState : uint8_t
+{
+    FLEET_CONN_CLOSED = 0,
+    FLEET_CONN_IDLE,       // connexion gardée ouverte entre deux heartbeats
+    FLEET_CONN_CONNECTING,
+    FLEET_CONN_SENDING,
+    FLEET_CONN_RECEIVING,
+    FLEET_CONN_LOST,       // Wi-Fi perdu pendant la requête : échec au timeout, comme sur le device
+};
+
+struct FleetDevice
+{
+    int id;
+    char uuid[37];
+    uint32_t rng;
+    uint32_t bootAt;
+    bool booted;
+    float outageDraw; // comparé à FleetOutage::fraction
+
+    SensorBuffer buffer;
+    uint32_t nextSample;
+    uint32_t replayOffset;
+    uint32_t eventStart;
+    float eventAmplitude;
+    float baseline[4];
+
+    // Wi-Fi
+    WifiConnectState wifi;
+    bool associated;
+    bool linkUp;
+    uint32_t linkReadyAt;
+    uint32_t nextWifiStep;
+
+    // Heartbeat
+    IngestEndpointSet endpoints;
+    bool debugEnabled;
+    uint32_t nextHeartbeat;
+    uint32_t requestStart;
+    uint32_t deadline;
+    int endpointIndex;
+    int recordsInFlight;
+
+    // Connexion
+    int fd;
+    FleetConnState conn;
+    char activeUrl[INGEST_URL_MAX];
+    std::string out;
+    size_t outSent;
+    std::string in;
+};
+
+void fleetDeviceInit(FleetContext &context, FleetDevice &device, int id);
+
+// Avancer le device jusqu'à now (boot, Wi-Fi, lectures, heartbeat, timeouts)
+void fleetDeviceTick(FleetContext &context, FleetDevice &device, uint32_t now);
+
+// Événement epoll sur la socket du device
+void fleetDeviceOnIo(FleetContext &context, FleetDevice &device, uint32_t events, uint32_t now);
@@ -0,0 +1,271 @@
+// Simulateur de flotte : N devices virtuels dans un seul processus, chacun avec le SensorBuffer,
+// les conversions, le payload du heartbeat, la machine d'état Wi-Fi et le choix d'endpoint du
+// firmware, contre un serveur d'ingestion local (tools/ingest_standin_servers.py --debug).
+//
+//   pio run -e fleet
+//   .pio/build/fleet/program --devices 5000 --url http://127.0.0.1:3100/prout-o-metre/heartbeat
+//       --boot-spread 60 --outage 120:60:0.3 --duration 600
+//
+// Le temps est virtuel (--speed accélère), les sockets sont réelles : une par device, gérées
+// par epoll. Le nombre de devices est borné par la limite de descripteurs (ulimit -n).
+#include "fleet_device.h"
+#include <config/config.h>
+#include <errno.h>
+#include <signal.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <time.h>
+#include <unistd.h>
+
+#define FLEET_TICK_MS 10        // Période d'avancement des devices (ms réelles)
+#define FLEET_EPOLL_EVENTS 1024 // Événements traités par appel à epoll_wait
+
+static volatile bool stopRequested = false;
+
+static void onSignal(int)
+{
+    stopRequested = true;
+}
+
+static uint64_t realTimeMs()
+{
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000 + now.tv_nsec / 1000000;
+}
+
+static void usage()
+{
+    fprintf(stderr,
+            "Usage : program [options]\n"
+            "  --devices N            devices virtuels (100)\n"
+            "  --duration S           durée virtuelle en secondes (300)\n"
+            "  --speed X              secondes virtuelles par seconde réelle (1)\n"
+            "  --boot-spread S        démarrages étalés sur S secondes (30)\n"
+            "  --url URL              endpoint d'ingestion, répétable (HEARTBEAT_URLS par défaut)\n"
+            "  --outage T:D:F         coupure Wi-Fi à T s pendant D s pour une fraction F des devices, répétable\n"
+            "  --replay FICHIER       CSV t_ms,mq135,mq136,mq4,max4466 (ADC brut) rejoué en boucle\n"
+            "  --noise N              bruit ADC des capteurs de gaz (4)\n"
+            "  --events-per-hour N    événements synthétiques par device (2)\n"
+            "  --report S             période des rapports en secondes réelles (10)\n"
+            "  --seed N               graine des signaux et des UUID (1)\n");
+}
+
+static bool loadReplay(const char *path, std::vector<FleetReplaySample> &replay)
+{
+    FILE *file = fopen(path, "r");
+    if (file == NULL)
+        return false;
+
+    char line[256];
+    while (fgets(line, sizeof(line), file))
+    {
+        unsigned time, mq135, mq136, mq4, mic;
+        if (sscanf(line, "%u,%u,%u,%u,%u", &time, &mq135, &mq136, &mq4, &mic) != 5)
+            continue; // en-tête ou ligne invalide
+        FleetReplaySample sample;
+        sample.time = time;
+        sample.data.mq135Value = mq135;
+        sample.data.mq136Value = mq136;
+        sample.data.mq4Value = mq4;
+        sample.data.max4466Value = mic;
+        replay.push_back(sample);
+    }
+    fclose(file);
+
+    // Temps relatifs au premier échantillon
+    if (!replay.empty())
+    {
+        uint32_t origin = replay.front().time;
+        for (FleetReplaySample &sample : replay)
+            sample.time -= origin;
+    }
+    return !replay.empty();
+}
+
+static bool parseArgs(int argc, char **argv, FleetConfig &config)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        const char *arg = argv[i];
+        const char *value = i + 1 < argc ? argv[i + 1] : NULL;
+        if (strcmp(arg, "--help") == 0 || value == NULL)
+            return false;
+        i++;
+
+        if (strcmp(arg, "--devices") == 0)
+            config.deviceCount = atoi(value);
+        else if (strcmp(arg, "--duration") == 0)
+            config.duration = atof(value) * 1000;
+        else if (strcmp(arg, "--speed") == 0)
+            config.speed = atof(value);
+        else if (strcmp(arg, "--boot-spread") == 0)
+            config.bootSpread = atof(value) * 1000;
+        else if (strcmp(arg, "--url") == 0)
+            config.urls.push_back(value);
+        else if (strcmp(arg, "--noise") == 0)
+            config.noise = atof(value);
+        else if (strcmp(arg, "--events-per-hour") == 0)
+            config.eventsPerHour = atof(value);
+        else if (strcmp(arg, "--report") == 0)
+            config.reportInterval = atof(value) * 1000;
+        else if (strcmp(arg, "--seed") == 0)
+            config.seed = strtoul(value, NULL, 10);
+        else if (strcmp(arg, "--outage") == 0)
+        {
+            float start, duration, fraction;
+            if (sscanf(value, "%f:%f:%f", &start, &duration, &fraction) != 3)
+                return false;
+            config.outages.push_back({(uint32_t)(start * 1000), (uint32_t)(duration * 1000), fraction});
+        }
+        else if (strcmp(arg, "--replay") == 0)
+        {
+            if (!loadReplay(value, config.replay))
+            {
+                fprintf(stderr, "Impossible de lire %s\n", value);
+                return false;
+            }
+        }
+        else
+            return false;
+    }
+
+    if (config.urls.empty())
+    {
+        for (int i = 0; i < HEARTBEAT_URL_COUNT; i++)
+            config.urls.push_back(HEARTBEAT_URLS[i]);
+    }
+    return config.deviceCount > 0 && config.speed > 0;
+}
+
+// Percentile de l'histogramme des latences (ms)
+static uint32_t latencyPercentile(const uint32_t *histogram, float percentile)
+{
+    uint64_t total = 0;
+    for (int i = 0; i < FLEET_LATENCY_BUCKETS; i++)
+        total += histogram[i];
+    if (total == 0)
+        return 0;
+
+    uint64_t target = (uint64_t)(total * percentile);
+    uint64_t seen = 0;
+    for (int i = 0; i < FLEET_LATENCY_BUCKETS; i++)
+    {
+        seen += histogram[i];
+        if (seen > target)
+            return i;
+    }
+    return FLEET_LATENCY_BUCKETS - 1;
+}
+
+// Rapport sur l'intervalle écoulé (rates en secondes réelles) et totaux
+static void report(const FleetContext &context, const std::vector<FleetDevice> &devices, FleetStats &previous,
+                   uint32_t virtualNow, float realSeconds, bool final)
+{
+    const FleetStats &stats = context.stats;
+    int booted = 0, online = 0;
+    for (const FleetDevice &device : devices)
+    {
+        booted += device.booted;
+        online += device.linkUp;
+    }
+
+    uint32_t histogram[FLEET_LATENCY_BUCKETS];
+    for (int i = 0; i < FLEET_LATENCY_BUCKETS; i++)
+        histogram[i] = final ? stats.latencyHistogram[i] : stats.latencyHistogram[i] - previous.latencyHistogram[i];
+
+    const FleetStats &base = final ? FleetStats() : previous;
+    float seconds = std::max(realSeconds, 0.001f);
+    uint64_t lost = stats.recordsOverwritten + stats.recordsLostInFlight;
+    uint64_t accounted = stats.recordsDelivered + lost;
+
+    printf("%s t=%us devices=%d/%d en ligne=%d | req/s=%.1f ok/s=%.1f échecs=%llu timeouts=%llu | "
+           "envoyé=%.1f ko/s reçu=%.1f ko/s | latence p50=%ums p99=%ums | bascules=%llu reconnexions wifi=%llu | "
+           "cumul échantillons livrés=%llu perdus=%llu (%.2f%%) non demandés=%llu",
+           final ? "[TOTAL]" : "[FLEET]", virtualNow / 1000, booted, (int)devices.size(), online,
+           (stats.requests - base.requests) / seconds, (stats.responsesOk - base.responsesOk) / seconds,
+           (unsigned long long)(stats.failures - base.failures), (unsigned long long)(stats.timeouts - base.timeouts),
+           (stats.bytesSent - base.bytesSent) / 1024.0f / seconds,
+           (stats.bytesReceived - base.bytesReceived) / 1024.0f / seconds,
+           latencyPercentile(histogram, 0.5f), latencyPercentile(histogram, 0.99f),
+           (unsigned long long)(stats.failovers - base.failovers),
+           (unsigned long long)(stats.wifiReconnects - base.wifiReconnects),
+           (unsigned long long)stats.recordsDelivered, (unsigned long long)lost,
+           accounted ? 100.0 * lost / accounted : 0.0, (unsigned long long)stats.recordsNotRequested);
+    if (stats.readingsSkipped)
+        printf(" | lectures sautées (simulateur en retard)=%llu", (unsigned long long)stats.readingsSkipped);
+    printf("\n");
+    fflush(stdout);
+
+    previous = stats;
+}
+
+int main(int argc, char **argv)
+{
+    static FleetContext context;
+    if (!parseArgs(argc, argv, context.config))
+    {
+        usage();
+        return 1;
+    }
+    const FleetConfig &config = context.config;
+
+    // Une socket par device
+    rlimit limit;
+    getrlimit(RLIMIT_NOFILE, &limit);
+    limit.rlim_cur = limit.rlim_max;
+    setrlimit(RLIMIT_NOFILE, &limit);
+    if ((rlim_t)config.deviceCount + 16 > limit.rlim_cur)
+        fprintf(stderr, "Attention : %d devices pour %lu descripteurs (ulimit -n)\n",
+                config.deviceCount, (unsigned long)limit.rlim_cur);
+
+    context.epollFd = epoll_create1(EPOLL_CLOEXEC);
+    if (context.epollFd < 0)
+    {
+        perror("epoll_create1");
+        return 1;
+    }
+    signal(SIGINT, onSignal);
+    signal(SIGPIPE, SIG_IGN);
+
+    // Les devices ne sont jamais déplacés : epoll garde leur adresse
+    std::vector<FleetDevice> devices(config.deviceCount);
+    for (int i = 0; i < config.deviceCount; i++)
+        fleetDeviceInit(context, devices[i], i);
+
+    fprintf(stderr, "Flotte : %d devices, %zu endpoint(s), x%.1f, %u s virtuelles\n",
+            config.deviceCount, config.urls.size(), config.speed, config.duration / 1000);
+
+    static FleetStats previous;
+    uint64_t realStart = realTimeMs();
+    uint64_t lastReport = realStart;
+    epoll_event events[FLEET_EPOLL_EVENTS];
+    uint32_t virtualNow = 0;
+
+    while (!stopRequested && virtualNow < config.duration)
+    {
+        int count = epoll_wait(context.epollFd, events, FLEET_EPOLL_EVENTS, FLEET_TICK_MS);
+        if (count < 0 && errno != EINTR)
+        {
+            perror("epoll_wait");
+            break;
+        }
+
+        uint64_t realNow = realTimeMs();
+        virtualNow = (uint32_t)((realNow - realStart) * config.speed);
+
+        for (int i = 0; i < count; i++)
+            fleetDeviceOnIo(context, *(FleetDevice *)events[i].data.ptr, events[i].events, virtualNow);
+        for (FleetDevice &device : devices)
+            fleetDeviceTick(context, device, virtualNow);
+
+        if (realNow - lastReport >= config.reportInterval)
+        {
+            report(context, devices, previous, virtualNow, (realNow - lastReport) / 1000.0f, false);
+            lastReport = realNow;
+        }
+    }
+
+    report(context, devices, previous, virtualNow, (realTimeMs() - realStart) / 1000.0f, true);
+    return 0;
+}
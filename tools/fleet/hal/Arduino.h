@@ -0,0 +1,63 @@
+#pragma once
+// Fausse couche Arduino du simulateur de flotte et des tests : uniquement ce qu'utilisent les
+// modules du firmware liés dans les binaires hôtes (voir [env:fleet] et [env:native] dans platformio.ini)
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+#include <string>
+
+using std::max;
+using std::min;
+
+#define INPUT 0x01
+
+// Horloge virtuelle : celle du device simulé en cours de traitement
+uint32_t millis();
+uint32_t micros();
+void delay(uint32_t ms);
+void halSetMillis(uint32_t now);
+
+void pinMode(uint8_t pin, uint8_t mode);
+uint16_t analogRead(uint8_t pin);
+
+class String
+{
+private:
+    std::string value;
+
+public:
+    String(const char *text = "") : value(text ? text : "") {}
+    String(const std::string &text) : value(text) {}
+
+    const char *c_str() const { return value.c_str(); }
+    size_t length() const { return value.length(); }
+    bool operator==(const char *text) const { return value == text; }
+    bool operator!=(const char *text) const { return value != text; }
+    String &operator+=(const String &other)
+    {
+        value += other.value;
+        return *this;
+    }
+    friend String operator+(const String &a, const String &b) { return String(a.value + b.value); }
+};
+
+// Port série : écrit sur stderr pour ne pas se mêler aux rapports du simulateur
+class FakeSerial
+{
+public:
+    void begin(unsigned long) {}
+    void print(const char *text) { fputs(text, stderr); }
+    void print(const String &text) { print(text.c_str()); }
+    void print(double value, int digits = 2) { fprintf(stderr, "%.*f", digits, value); }
+    void println() { fputc('\n', stderr); }
+    void println(const char *text) { fprintf(stderr, "%s\n", text); }
+    void println(const String &text) { println(text.c_str()); }
+    void println(double value, int digits = 2) { fprintf(stderr, "%.*f\n", digits, value); }
+    int printf(const char *format, ...) __attribute__((format(printf, 2, 3)));
+};
+
+extern FakeSerial Serial;
@@ -0,0 +1,5 @@
+#pragma once
+#include <stdint.h>
+
+// µs depuis le démarrage, dérivé de l'horloge virtuelle du device simulé
+int64_t esp_timer_get_time();
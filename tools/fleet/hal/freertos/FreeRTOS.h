@@ -0,0 +1,10 @@
+#pragma once
+#include <stdint.h>
+
+// Sous-ensemble utilisé par les modules liés dans le simulateur et les tests natifs
+typedef int BaseType_t;
+typedef uint32_t TickType_t;
+
+#define pdFALSE 0
+#define pdTRUE 1
+#define portMAX_DELAY 0xffffffffUL
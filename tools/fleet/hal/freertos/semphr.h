@@ -0,0 +1,27 @@
+#pragma once
+#include "FreeRTOS.h"
+#include <mutex>
+
+// Mutex FreeRTOS sur std::mutex (le délai d'attente est ignoré : attente illimitée)
+struct StaticSemaphore_t
+{
+    std::mutex mutex;
+};
+typedef StaticSemaphore_t *SemaphoreHandle_t;
+
+inline SemaphoreHandle_t xSemaphoreCreateMutexStatic(StaticSemaphore_t *storage)
+{
+    return storage;
+}
+
+inline BaseType_t xSemaphoreTake(SemaphoreHandle_t semaphore, TickType_t)
+{
+    semaphore->mutex.lock();
+    return pdTRUE;
+}
+
+inline BaseType_t xSemaphoreGive(SemaphoreHandle_t semaphore)
+{
+    semaphore->mutex.unlock();
+    return pdTRUE;
+}
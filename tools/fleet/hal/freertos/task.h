@@ -0,0 +1,3 @@
+#pragma once
+
+typedef void *TaskHandle_t;
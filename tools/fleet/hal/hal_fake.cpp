@@ -0,0 +1,60 @@
+#include <Arduino.h>
+#include <esp_timer.h>
+#include <stdarg.h>
+#include <modules/acoustic/acoustic_manager.h>
+
+FakeSerial Serial;
+
+static uint32_t currentMillis = 0;
+
+void halSetMillis(uint32_t now)
+{
+    currentMillis = now;
+}
+
+uint32_t millis()
+{
+    return currentMillis;
+}
+
+uint32_t micros()
+{
+    return currentMillis * 1000;
+}
+
+int64_t esp_timer_get_time()
+{
+    return (int64_t)currentMillis * 1000;
+}
+
+// Le temps virtuel avance avec la boucle d'événements, jamais en bloquant
+void delay(uint32_t) {}
+
+void pinMode(uint8_t, uint8_t) {}
+
+// Les signaux sont injectés directement en SensorData par le simulateur
+uint16_t analogRead(uint8_t)
+{
+    return 0;
+}
+
+int FakeSerial::printf(const char *format, ...)
+{
+    va_list args;
+    va_start(args, format);
+    int written = vfprintf(stderr, format, args);
+    va_end(args);
+    return written;
+}
+
+// Pas d'étage acoustique simulé : les enregistrements n'ont pas de caractéristiques spectrales
+bool acousticManagerGetFeatures(AcousticFeatures &features)
+{
+    (void)features;
+    return false;
+}
+
+float acousticManagerGetCpuLoad()
+{
+    return 0.0f;
+}
@@ -0,0 +1,227 @@
+"""
+Vérification du choix d'endpoint d'ingestion (src/modules/ingest/) de bout en bout :
+le simulateur de flotte (code du firmware) contre les serveurs de substitution.
+
+  1. répartition : après la réception de la liste "ingest_endpoints", chaque serveur
+     reçoit ~1/N des devices (HRW), et chaque device reste sur un seul serveur ;
+  2. bascule rapide : un serveur tombe (connexions gardées ouvertes en 503, nouvelles
+     refusées), chacun de ses devices passe sur un autre en moins de --max-failover
+     secondes virtuelles ;
+  3. déplacement minimal : les devices des autres serveurs ne bougent pas, ceux du
+     serveur arrêté se répartissent entre les restants ;
+  4. compteur : les bascules comptées par le firmware (ingestSelect) valent 0 avant la
+     panne (la réaffectation par le serveur n'en est pas une), puis une par device déplacé.
+
+Usage :
+    pio run -e fleet
+    python tools/ingest_failover_check.py --fleet .pio/build/fleet/program --devices 600 --speed 10
+"""
+import argparse
+import math
+import os
+import re
+import signal
+import subprocess
+import sys
+import threading
+import time
+from collections import Counter, defaultdict
+
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+from ingest_standin_servers import StandinServer  # noqa: E402
+
+HEARTBEAT_INTERVAL_S = 5.0  # FLEET_HEARTBEAT_INTERVAL
+HTTP_TIMEOUT_S = 3.0        # FLEET_HTTP_TIMEOUT
+MAX_FAILURES = 3            # INGEST_MAX_CONSECUTIVE_FAILURES
+# Pire cas : 1er heartbeat jusqu'à un intervalle après la panne, puis au plus MAX_FAILURES
+# échecs qui durent chacun jusqu'au timeout avant l'intervalle suivant
+MAX_FAILOVER_S = HEARTBEAT_INTERVAL_S + MAX_FAILURES * (HTTP_TIMEOUT_S + HEARTBEAT_INTERVAL_S)
+FAILOVER_RE = re.compile(r"bascules=(\d+)")
+TIMEOUT_RE = re.compile(r"timeouts=(\d+)")
+
+
+class RecordingServer(StandinServer):
+    """Serveur de substitution qui date chaque heartbeat reçu."""
+
+    def __init__(self, *args):
+        super().__init__(*args)
+        self.log = []
+
+    def start(self):
+        super().start()
+        # Connexions coupées par la flotte à l'arrêt : pas de trace d'erreur
+        self.httpd.handle_error = lambda request, client_address: None
+
+    def handle(self, handler, uuid):
+        with self.lock:
+            self.log.append((time.monotonic(), uuid))
+        super().handle(handler, uuid)
+
+
+class FleetRunner:
+    """Simulateur de flotte lancé en sous-processus ; cumule les bascules de ses rapports."""
+
+    def __init__(self, command):
+        self.process = subprocess.Popen(command, stdout=subprocess.PIPE, text=True)
+        self.failovers = []  # (instant, bascules cumulées, timeouts cumulés)
+        self.lock = threading.Lock()
+        threading.Thread(target=self.read, daemon=True).start()
+
+    def read(self):
+        failovers = timeouts = 0
+        for line in self.process.stdout:
+            if line.startswith("[FLEET]"):
+                failovers += int(FAILOVER_RE.search(line).group(1))
+                timeouts += int(TIMEOUT_RE.search(line).group(1))
+                with self.lock:
+                    self.failovers.append((time.monotonic(), failovers, timeouts))
+
+    def totals_at(self, instant):
+        """(bascules, timeouts) cumulés au dernier rapport avant instant."""
+        with self.lock:
+            return max([(f, t) for at, f, t in self.failovers if at <= instant], default=(0, 0))
+
+    def stop(self):
+        self.process.send_signal(signal.SIGINT)
+        try:
+            self.process.wait(timeout=10)
+        except subprocess.TimeoutExpired:
+            self.process.kill()
+
+
+def requests_between(servers, start, end):
+    """uuid -> Counter(port -> requêtes) sur [start, end)."""
+    seen = defaultdict(Counter)
+    for port, server in servers.items():
+        with server.lock:
+            for at, uuid in server.log:
+                if start <= at < end:
+                    seen[uuid][port] += 1
+    return seen
+
+
+def within(share, expected, devices):
+    # 4 écarts-types d'une binomiale : tolérance qui ne dépend que de la taille de la flotte
+    return abs(share - expected) <= 4 * math.sqrt(expected * (1 - expected) / devices)
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Vérification HRW / bascule contre les serveurs de substitution")
+    parser.add_argument("--fleet", default=".pio/build/fleet/program", help="binaire du simulateur de flotte")
+    parser.add_argument("--devices", type=int, default=600)
+    parser.add_argument("--servers", type=int, default=3)
+    parser.add_argument("--speed", type=float, default=10.0, help="secondes virtuelles par seconde réelle")
+    parser.add_argument("--base-port", type=int, default=3300)
+    parser.add_argument("--path", default="/prout-o-metre/heartbeat")
+    parser.add_argument("--max-failover", type=float, default=MAX_FAILOVER_S,
+                        help="délai max de bascule en secondes virtuelles")
+    args = parser.parse_args()
+
+    def real(virtual_seconds):
+        return virtual_seconds / args.speed
+
+    ports = [args.base_port + i for i in range(args.servers)]
+    endpoints = ["http://127.0.0.1:%d%s" % (port, args.path) for port in ports]
+    servers = {port: RecordingServer("127.0.0.1", port, endpoints, False, None) for port in ports}
+    for server in servers.values():
+        server.start()
+
+    # Seule la première URL est connue au démarrage : les devices apprennent la liste du serveur
+    fleet = FleetRunner([args.fleet, "--devices", str(args.devices), "--url", endpoints[0],
+                         "--speed", str(args.speed), "--duration", "100000", "--boot-spread", "10",
+                         "--report", "0.5"])
+    failures = []
+
+    def check(ok, message):
+        print("[%s] %s" % ("OK" if ok else "ÉCHEC", message), flush=True)
+        if not ok:
+            failures.append(message)
+
+    try:
+        # Démarrage (calibration 7,5 s + étalement 10 s) puis quelques heartbeats
+        time.sleep(real(45))
+        window_start = time.monotonic()
+        time.sleep(real(8 * HEARTBEAT_INTERVAL_S))
+        window_end = time.monotonic()
+
+        # 1. Répartition
+        before = requests_between(servers, window_start, window_end)
+        assignment = {uuid: counts.most_common(1)[0][0] for uuid, counts in before.items()}
+        stable = sum(1 for counts in before.values() if len(counts) == 1)
+        check(len(assignment) >= 0.99 * args.devices,
+              "%d/%d devices actifs pendant la fenêtre de mesure" % (len(assignment), args.devices))
+        check(stable == len(assignment), "%d/%d devices sur un seul serveur" % (stable, len(assignment)))
+        per_server = Counter(assignment.values())
+        for port in ports:
+            share = per_server[port] / max(len(assignment), 1)
+            check(within(share, 1.0 / len(ports), len(assignment)),
+                  "serveur %d : %.1f %% des devices (attendu %.1f %%)" % (port, 100 * share, 100.0 / len(ports)))
+        failovers_before, timeouts_before = fleet.totals_at(time.monotonic())
+        check(failovers_before == 0, "%d bascule(s) comptée(s) avant la panne" % failovers_before)
+
+        # 2. Panne d'un serveur
+        # Panne : les connexions gardées ouvertes reçoivent des 503, les nouvelles sont refusées
+        stopped = ports[-1]
+        servers[stopped].failure_rate = 1.0
+        servers[stopped].stop()
+        stop_time = time.monotonic()
+        # Fenêtre close avant la fin d'éviction (60 s) : pas de retour sur le serveur arrêté
+        time.sleep(real(45))
+        end_time = time.monotonic()
+
+        victims = {uuid for uuid, port in assignment.items() if port == stopped}
+        delays = []
+        for port, server in servers.items():
+            if port == stopped:
+                continue
+            with server.lock:
+                first_seen = {}
+                for at, uuid in server.log:
+                    if at >= stop_time and uuid in victims and uuid not in first_seen:
+                        first_seen[uuid] = at
+            delays.extend((at - stop_time) * args.speed for at in first_seen.values())
+        moved_victims = len(delays)
+        check(moved_victims == len(victims), "%d/%d devices du serveur arrêté ont basculé" % (moved_victims, len(victims)))
+        if delays:
+            delays.sort()
+            worst = delays[-1]
+            check(worst <= args.max_failover,
+                  "bascule en %.1f s virtuelles au pire (médiane %.1f s, limite %.1f s)"
+                  % (worst, delays[len(delays) // 2], args.max_failover))
+
+        # 3. Déplacement minimal
+        after = requests_between(servers, stop_time + real(2 * HEARTBEAT_INTERVAL_S), end_time)
+        # Un timeout isolé vers un serveur sain (serveur Python chargé) peut en déplacer un : 1 % toléré
+        healthy = sum(1 for port in assignment.values() if port != stopped)
+        moved_others = sum(1 for uuid, port in assignment.items()
+                           if port != stopped and uuid in after and set(after[uuid]) != {port})
+        check(moved_others <= healthy // 100,
+              "%d/%d device(s) d'un serveur sain déplacé(s)" % (moved_others, healthy))
+        landed = Counter(after[uuid].most_common(1)[0][0] for uuid in victims if uuid in after)
+        remaining = [port for port in ports if port != stopped]
+        for port in remaining:
+            share = landed[port] / max(len(victims), 1)
+            check(within(share, 1.0 / len(remaining), max(len(victims), 1)),
+                  "serveur %d : %.1f %% des devices déplacés (attendu %.1f %%)"
+                  % (port, 100 * share, 100.0 / len(remaining)))
+
+        # 4. Compteur de bascules du firmware
+        failovers, timeouts = fleet.totals_at(end_time)
+        failovers -= failovers_before
+        # Une par device déplacé, à quelques-unes près : une réponse lente du serveur qui tombe
+        # le délaisse pour latence (pas une bascule), un timeout vers le nouveau en ajoute une
+        timeouts -= timeouts_before
+        check(abs(failovers - len(victims)) <= max(timeouts, 1),
+              "%d bascules comptées pour %d devices déplacés (%d timeouts pendant la panne)"
+              % (failovers, len(victims), timeouts))
+    finally:
+        fleet.stop()
+        for server in servers.values():
+            server.stop()
+
+    print("[INFO] %s" % ("Tout est conforme" if not failures else "%d vérification(s) en échec" % len(failures)))
+    return 1 if failures else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,191 @@
+"""
+Serveurs d'ingestion de substitution pour tester la bascule multi-endpoints du device
+(src/modules/ingest/) : plusieurs serveurs HTTP locaux, chacun avec une latence et
+un taux d'échec injectables pendant l'exécution.
+
+Chaque serveur répond au heartbeat avec "ingest_endpoints" (la liste de tous les
+serveurs), ce qui suffit à configurer le device sans reflasher : seule la première
+URL de HEARTBEAT_URLS doit pointer vers l'un d'eux.
+
+Commandes sur l'entrée standard :
+    latency <port> <ms>    ajoute <ms> de latence aux réponses
+    fail <port> <taux>     répond 503 avec cette probabilité (0..1)
+    hang <port>            ne répond plus (le device tombe en timeout)
+    stop <port>            refuse les connexions
+    start <port>           rétablit un serveur (latence, échecs, hang remis à zéro)
+    stats                  requêtes reçues par serveur et par device
+
+Les captures rapides (POST binaire sur <URL>/capture) sont comptées, et enregistrées
+dans --capture-dir si fourni (à lire avec tools/burst_decoder.py).
+
+Avec --debug, les réponses demandent aussi les échantillons des capteurs ("debug": true),
+comme pour mesurer le débit complet avec le simulateur de flotte (tools/fleet/).
+
+Usage :
+    python tools/ingest_standin_servers.py --count 3 --base-port 3100 --advertise 192.168.0.18
+"""
+import argparse
+import json
+import os
+import random
+import sys
+import threading
+import time
+from collections import Counter
+from http.server import BaseHTTPRequestHandler, ThreadingHTTPServer
+
+
+class StandinServer:
+    def __init__(self, host, port, endpoints, debug, capture_dir):
+        self.host = host
+        self.port = port
+        self.endpoints = endpoints
+        self.debug = debug
+        self.capture_dir = capture_dir
+        self.captures = 0
+        self.latency_ms = 0
+        self.failure_rate = 0.0
+        self.hang = False
+        self.requests = Counter()
+        self.failures = 0
+        self.httpd = None
+        self.lock = threading.Lock()
+
+    def start(self):
+        if self.httpd is not None:
+            return
+        server = self
+
+        class Handler(BaseHTTPRequestHandler):
+            protocol_version = "HTTP/1.1"
+
+            def do_POST(self):
+                length = int(self.headers.get("Content-Length", 0))
+                payload = self.rfile.read(length)
+                if self.path.endswith("/capture"):
+                    server.handle_capture(self, self.headers.get("X-Device-UUID", "?"), payload)
+                    return
+                try:
+                    uuid = json.loads(payload).get("uuid", "?")
+                except ValueError:
+                    uuid = "?"
+                server.handle(self, uuid)
+
+            def log_message(self, format, *args):
+                pass
+
+        self.httpd = ThreadingHTTPServer((self.host, self.port), Handler)
+        self.httpd.daemon_threads = True
+        threading.Thread(target=self.httpd.serve_forever, daemon=True).start()
+
+    def stop(self):
+        if self.httpd is None:
+            return
+        self.httpd.shutdown()
+        self.httpd.server_close()
+        self.httpd = None
+
+    def reset(self):
+        self.latency_ms = 0
+        self.failure_rate = 0.0
+        self.hang = False
+
+    def handle_capture(self, handler, uuid, payload):
+        with self.lock:
+            self.captures += 1
+            index = self.captures
+        if self.capture_dir:
+            path = os.path.join(self.capture_dir, "%s_%d_%d.bin" % (uuid, self.port, index))
+            with open(path, "wb") as f:
+                f.write(payload)
+        print("[INFO] %d : capture de %s (%d octets)" % (self.port, uuid, len(payload)), flush=True)
+        handler.send_response(200)
+        handler.send_header("Content-Length", "0")
+        handler.end_headers()
+
+    def handle(self, handler, uuid):
+        with self.lock:
+            self.requests[uuid] += 1
+        if self.hang:
+            time.sleep(3600)
+            return
+        if self.latency_ms:
+            time.sleep(self.latency_ms / 1000.0)
+
+        if random.random() < self.failure_rate:
+            with self.lock:
+                self.failures += 1
+            status, body = 503, b"{}"
+        else:
+            status, body = 200, json.dumps({"debug": self.debug, "ingest_endpoints": self.endpoints}).encode()
+
+        handler.send_response(status)
+        handler.send_header("Content-Type", "application/json")
+        handler.send_header("Content-Length", str(len(body)))
+        handler.end_headers()
+        handler.wfile.write(body)
+
+
+def print_stats(servers):
+    for server in servers.values():
+        state = "arrêté" if server.httpd is None else "hang" if server.hang else "actif"
+        total = sum(server.requests.values())
+        print("[STATS] %d (%s, +%d ms, échec %.0f%%) : %d requêtes, %d échecs, %d devices, %d captures" % (
+            server.port, state, server.latency_ms, server.failure_rate * 100, total, server.failures,
+            len(server.requests), server.captures), flush=True)
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Serveurs d'ingestion de substitution avec injection de pannes")
+    parser.add_argument("--host", default="0.0.0.0")
+    parser.add_argument("--advertise", default="127.0.0.1", help="IP des serveurs telle que vue par les devices")
+    parser.add_argument("--base-port", type=int, default=3100)
+    parser.add_argument("--count", type=int, default=3)
+    parser.add_argument("--path", default="/prout-o-metre/heartbeat")
+    parser.add_argument("--debug", action="store_true", help="demander les échantillons des capteurs")
+    parser.add_argument("--capture-dir", help="dossier où enregistrer les captures rapides reçues")
+    args = parser.parse_args()
+
+    if args.capture_dir:
+        os.makedirs(args.capture_dir, exist_ok=True)
+
+    ports = [args.base_port + i for i in range(args.count)]
+    endpoints = ["http://%s:%d%s" % (args.advertise, port, args.path) for port in ports]
+    servers = {port: StandinServer(args.host, port, endpoints, args.debug, args.capture_dir) for port in ports}
+    for server in servers.values():
+        server.start()
+    for url in endpoints:
+        print("[INFO] Écoute sur %s" % url, flush=True)
+
+    for line in sys.stdin:
+        words = line.split()
+        if not words:
+            continue
+        try:
+            command = words[0]
+            if command == "stats":
+                print_stats(servers)
+                continue
+            server = servers[int(words[1])]
+            if command == "latency":
+                server.latency_ms = int(words[2])
+            elif command == "fail":
+                server.failure_rate = float(words[2])
+            elif command == "hang":
+                server.hang = True
+            elif command == "stop":
+                server.stop()
+            elif command == "start":
+                server.reset()
+                server.start()
+            else:
+                print("[ERREUR] Commande inconnue : %s" % command, flush=True)
+        except (IndexError, KeyError, ValueError):
+            print("[ERREUR] Commande invalide : %s" % line.strip(), flush=True)
+
+    # Entrée standard fermée (lancement en arrière-plan) : continuer à servir
+    threading.Event().wait()
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,148 @@
+"""
+Décodeur des logs binaires du firmware (LOG_OUTPUT_BINARY true, voir
+src/modules/log/log_manager.h).
+
+Chaque trame contient l'adresse du format en flash : le texte est retrouvé dans
+l'ELF du firmware correspondant, puis formaté avec les arguments bruts.
+
+Usage :
+    python tools/log_decoder.py .pio/build/esp32doit-devkit-v1/firmware.elf capture.bin
+    python tools/log_decoder.py .pio/build/esp32doit-devkit-v1/firmware.elf /dev/ttyUSB0 --baud 115200
+"""
+import argparse
+import re
+import struct
+import sys
+
+FRAME_SYNC = 0xA5
+HEADER_SIZE = 16
+LEVELS = "DIWE"
+ARG_INT32, ARG_UINT32, ARG_INT64, ARG_UINT64, ARG_FLOAT, ARG_STRING, ARG_POINTER = range(7)
+SPEC_RE = re.compile(r"%([-+ #0-9.]*)[hljztL]*([diuxXocsfFeEgGaAp%])")
+
+
+# -------------------
+# Lecture de l'ELF (sections chargées en mémoire)
+# -------------------
+class ElfStrings:
+    def __init__(self, path):
+        with open(path, "rb") as f:
+            self.data = f.read()
+        if self.data[:4] != b"\x7fELF" or self.data[4] != 1:
+            raise ValueError("ELF 32 bits attendu")
+        shoff, = struct.unpack_from("<I", self.data, 0x20)
+        shentsize, shnum = struct.unpack_from("<HH", self.data, 0x2E)
+        self.sections = []
+        for i in range(shnum):
+            _, sh_type, _, addr, offset, size = struct.unpack_from("<IIIIII", self.data, shoff + i * shentsize)
+            if sh_type == 1 and addr != 0:  # SHT_PROGBITS chargée
+                self.sections.append((addr, offset, size))
+
+    def string_at(self, address):
+        for addr, offset, size in self.sections:
+            if addr <= address < addr + size:
+                start = offset + address - addr
+                end = self.data.index(b"\0", start)
+                return self.data[start:end].decode("utf-8", errors="replace")
+        return "<format inconnu 0x%08x>" % address
+
+
+# -------------------
+# Formatage
+# -------------------
+def decode_args(types, raw_args, strings):
+    values = []
+    i = 0
+    while i < len(types):
+        arg_type, raw = types[i], raw_args[i]
+        if arg_type in (ARG_INT64, ARG_UINT64) and i + 1 < len(types):
+            raw |= raw_args[i + 1] << 32
+            i += 1
+            if arg_type == ARG_INT64 and raw & (1 << 63):
+                raw -= 1 << 64
+        elif arg_type == ARG_INT32 and raw & (1 << 31):
+            raw -= 1 << 32
+        if arg_type == ARG_FLOAT:
+            raw = struct.unpack("<f", struct.pack("<I", raw))[0]
+        elif arg_type == ARG_STRING:
+            end = strings.find(b"\0", raw)
+            raw = strings[raw:end if end >= 0 else len(strings)].decode("utf-8", errors="replace")
+        values.append(raw)
+        i += 1
+    return values
+
+
+def format_message(fmt, values):
+    values = iter(values)
+
+    def replace(match):
+        flags, conversion = match.groups()
+        if conversion == "%":
+            return "%"
+        value = next(values, "<?>")
+        if conversion == "p":
+            return "0x%08x" % value
+        if conversion in "diuc" and isinstance(value, float):
+            value = int(value)
+        try:
+            return ("%" + flags + conversion.replace("u", "d")) % value
+        except (TypeError, ValueError):
+            return str(value)
+
+    return SPEC_RE.sub(replace, fmt)
+
+
+# -------------------
+# Trames
+# -------------------
+def decode_stream(elf, data):
+    pos = 0
+    while pos + HEADER_SIZE <= len(data):
+        if data[pos] != FRAME_SYNC:
+            pos += 1
+            continue
+        # Timestamp en µs sur 64 bits : pas de rebouclage (un u32 repasse à 0 toutes les 71,6 min)
+        level, argc, strings_size, timestamp, address = struct.unpack_from("<BBBQI", data, pos + 1)
+        end = pos + HEADER_SIZE + argc * 5 + strings_size
+        if end > len(data):
+            break
+        types = list(data[pos + HEADER_SIZE:pos + HEADER_SIZE + argc])
+        raw_args = list(struct.unpack_from("<%dI" % argc, data, pos + HEADER_SIZE + argc))
+        strings = data[end - strings_size:end]
+        values = decode_args(types, raw_args, strings)
+        fmt = "Log: %u messages perdus" if address == 0 else elf.string_at(address)
+        yield "%s %d.%03d %s" % (LEVELS[level & 3], timestamp // 1000000, timestamp // 1000 % 1000,
+                                 format_message(fmt, values).rstrip("\n"))
+        pos = end
+    return pos
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Décodage des logs binaires ProutOMetre")
+    parser.add_argument("elf", help="firmware.elf correspondant au firmware qui a produit les logs")
+    parser.add_argument("source", help="fichier de capture ou port série")
+    parser.add_argument("--baud", type=int, default=115200)
+    args = parser.parse_args()
+
+    elf = ElfStrings(args.elf)
+
+    if args.source.startswith("/dev/") or args.source.upper().startswith("COM"):
+        import serial  # type: ignore
+        port = serial.Serial(args.source, args.baud)
+        pending = b""
+        while True:
+            pending += port.read(port.in_waiting or 1)
+            gen = decode_stream(elf, pending)
+            try:
+                while True:
+                    print(next(gen), flush=True)
+            except StopIteration as stop:
+                pending = pending[stop.value:]
+    else:
+        with open(args.source, "rb") as f:
+            for line in decode_stream(elf, f.read()):
+                print(line)
+
+
+if __name__ == "__main__":
+    sys.exit(main())
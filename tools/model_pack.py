@@ -0,0 +1,184 @@
+"""
+Empaquetage des modèles d'inférence embarqués (format PMDL, voir
+src/modules/inference/inference_engine.h) et évaluation de référence.
+
+Usage :
+    python tools/model_pack.py tools/models/default_model.json --bin model.bin
+    python tools/model_pack.py tools/models/default_model.json --header src/modules/inference/inference_default_model.h
+    python tools/model_pack.py tools/models/default_model.json --eval features.json
+    python tools/model_pack.py tools/models/default_model.json --vectors test/data/inference_default_vectors.txt
+
+Le blob .bin est servi tel quel à l'URL transmise au device via "update_model_url".
+L'évaluation de référence reproduit exactement l'arithmétique du device (float32 puis entière).
+--vectors écrit le blob et les résultats attendus des "test_vectors" du modèle, comparés
+octet par octet au moteur C par test/test_inference (pio test -e native).
+"""
+import argparse
+import json
+import math
+import struct
+import zlib
+
+FORMAT_VERSION = 1
+KIND_DENSE = 1
+KIND_TREES = 2
+ACTIVATIONS = {"none": 0, "relu": 1}
+
+
+# -------------------
+# Empaquetage
+# -------------------
+def pack_payload(spec):
+    payload = bytearray()
+    for scale, offset in spec["input_quantization"]:
+        payload += struct.pack("<ff", scale, offset)
+    payload += struct.pack("<f", spec["output_scale"])
+
+    if spec["kind"] == "dense":
+        for layer in spec["layers"]:
+            weights = layer["weights"]
+            out_count, in_count = len(weights), len(weights[0])
+            payload += struct.pack("<BBBBi", in_count, out_count, ACTIVATIONS[layer["activation"]],
+                                   layer["shift"], layer["multiplier"])
+            for row in weights:
+                payload += struct.pack("<%db" % in_count, *row)
+            payload += struct.pack("<%di" % out_count, *layer["bias"])
+    else:
+        for tree in spec["trees"]:
+            payload += struct.pack("<H", len(tree["nodes"]))
+            for node in tree["nodes"]:
+                if "leaf" in node:
+                    payload += struct.pack("<bbHH", -1, 0, node["leaf"], 0)
+                else:
+                    payload += struct.pack("<bbHH", node["feature"], node["threshold"], node["left"], node["right"])
+            payload += struct.pack("<H", len(tree["leaves"]))
+            for leaf in tree["leaves"]:
+                payload += struct.pack("<%dh" % len(leaf), *leaf)
+    return bytes(payload)
+
+
+def pack(spec):
+    payload = pack_payload(spec)
+    kind = KIND_DENSE if spec["kind"] == "dense" else KIND_TREES
+    sections = len(spec["layers"]) if kind == KIND_DENSE else len(spec["trees"])
+    header = b"PMDL" + struct.pack("<HHBBBBII", FORMAT_VERSION, spec["version"], kind,
+                                   len(spec["input_quantization"]), len(spec["classes"]), sections,
+                                   len(payload), zlib.crc32(payload) & 0xFFFFFFFF)
+    return header + payload
+
+
+def write_header(spec, blob, path):
+    lines = ["// AUTO GENERATED FILE, DO NOT EDIT (tools/model_pack.py)",
+             "#pragma once",
+             "#include <stdint.h>",
+             "",
+             "// Modèle par défaut \"%s\" v%d, classes : %s" % (spec["name"], spec["version"], ", ".join(spec["classes"])),
+             "static const uint8_t INFERENCE_DEFAULT_MODEL[] = {"]
+    for i in range(0, len(blob), 16):
+        lines.append("    " + ", ".join("0x%02X" % b for b in blob[i:i + 16]) + ",")
+    lines.append("};")
+    with open(path, "w") as f:
+        f.write("\n".join(lines) + "\n")
+
+
+# -------------------
+# Évaluation de référence (arithmétique identique au device)
+# -------------------
+def f32(value):
+    return struct.unpack("<f", struct.pack("<f", value))[0]
+
+
+def clamp_int8(value):
+    return max(-128, min(127, value))
+
+
+def quantize(spec, features):
+    # Caractéristiques : nombres ou "nan", "inf", "-inf" (JSON standard)
+    inputs = []
+    for (scale, offset), x in zip(spec["input_quantization"], features):
+        # Chaque opération arrondie en float32, comme (features[i] - offset) * scale côté C
+        q = f32(f32(f32(float(x)) - f32(offset)) * f32(scale))
+        if math.isnan(q):
+            inputs.append(0)  # point zéro
+            continue
+        q = max(-128.0, min(127.0, q))  # écrêtage avant l'arrondi (infinis compris)
+        inputs.append(int(math.floor(abs(q) + 0.5) * (1 if q >= 0 else -1)))  # roundf : arrondi loin de zéro
+    return inputs
+
+
+def requantize(acc, multiplier, shift):
+    total = 31 + shift
+    return (acc * multiplier + (1 << (total - 1))) >> total
+
+
+def run(spec, inputs):
+    if spec["kind"] == "dense":
+        current = inputs
+        for layer in spec["layers"]:
+            out = []
+            for row, bias in zip(layer["weights"], layer["bias"]):
+                value = requantize(bias + sum(w * x for w, x in zip(row, current)),
+                                   layer["multiplier"], layer["shift"])
+                if layer["activation"] == "relu":
+                    value = max(0, value)
+                out.append(clamp_int8(value))
+            current = out
+        return current
+
+    outputs = [0] * len(spec["classes"])
+    for tree in spec["trees"]:
+        node = tree["nodes"][0]
+        while "leaf" not in node:
+            go_left = inputs[node["feature"]] <= node["threshold"]
+            node = tree["nodes"][node["left"] if go_left else node["right"]]
+        outputs = [o + v for o, v in zip(outputs, tree["leaves"][node["leaf"]])]
+    return outputs
+
+
+# -------------------
+# Vecteurs de test (test/test_inference)
+# -------------------
+def write_vectors(spec, blob, path):
+    # Caractéristiques en hexadécimal flottant : relues sans perte par strtof
+    lines = ["# AUTO GENERATED FILE, DO NOT EDIT (tools/model_pack.py --vectors)",
+             "blob " + blob.hex()]
+    for features in spec.get("test_vectors", []):
+        inputs = quantize(spec, features)
+        lines.append("features " + " ".join(f32(float(x)).hex() for x in features))
+        lines.append("inputs " + " ".join(str(v) for v in inputs))
+        lines.append("outputs " + " ".join(str(v) for v in run(spec, inputs)))
+    with open(path, "w") as f:
+        f.write("\n".join(lines) + "\n")
+    print(f"[INFO] {len(spec.get('test_vectors', []))} vecteurs de test écrits dans {path}")
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Empaquetage des modèles d'inférence PMDL")
+    parser.add_argument("spec", help="description JSON du modèle")
+    parser.add_argument("--bin", help="écrire le blob binaire")
+    parser.add_argument("--header", help="écrire le blob sous forme d'en-tête C")
+    parser.add_argument("--eval", help="fichier JSON : liste de vecteurs de caractéristiques")
+    parser.add_argument("--vectors", help="écrire le blob et les résultats attendus des test_vectors")
+    args = parser.parse_args()
+
+    with open(args.spec) as f:
+        spec = json.load(f)
+    blob = pack(spec)
+    print(f"[INFO] Modèle {spec['name']} v{spec['version']} : {len(blob)} octets")
+
+    if args.bin:
+        with open(args.bin, "wb") as f:
+            f.write(blob)
+    if args.header:
+        write_header(spec, blob, args.header)
+    if args.eval:
+        with open(args.eval) as f:
+            for features in json.load(f):
+                inputs = quantize(spec, features)
+                print(json.dumps({"inputs": inputs, "outputs": run(spec, inputs)}))
+    if args.vectors:
+        write_vectors(spec, blob, args.vectors)
+
+
+if __name__ == "__main__":
+    main()
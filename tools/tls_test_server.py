@@ -0,0 +1,127 @@
+"""
+Serveur HTTPS local pour mesurer le coût des handshakes TLS du device
+(complet contre repris), avec un certificat ECDSA P-256.
+
+Au premier lancement, une CA et un certificat serveur sont générés (openssl requis)
+dans tools/tls_test/ ; le PEM de la CA est affiché, à copier dans TLS_ROOT_CA
+(src/config/config.cpp), puis passer HEARTBEAT_URLS en https://<ip du PC>:8443/...
+
+Les statistiques côté device sont exposées sur http://<device>/metrics
+(proutometre_tls_handshake_us, proutometre_tls_handshake_peak_heap_bytes) et dans
+les logs ("TLS: Handshake complet|repris avec ... en ... µs (heap au pic : ...)").
+Mesure : lancer avec --no-keep-alive, laisser passer quelques heartbeats (le premier
+est complet, les suivants repris), puis redémarrer le device (RTC conservée) et
+couper l'alimentation (session relue en NVS).
+
+Nom du certificat : le device vérifie le nom passé à mbedtls_ssl_set_hostname, soit
+l'hôte de l'URL. mbedTLS 2.x (ESP-IDF 4.4, core Arduino 2.x) ne compare que le CN
+et les SAN de type DNS : un SAN IP seul n'est jamais accepté. Quand --cn est une
+IP, le certificat porte donc la même IP en SAN DNS (pour mbedTLS 2.x) et en SAN IP
+(pour les autres clients). Le certificat est régénéré si --cn change.
+
+Usage :
+    python tools/tls_test_server.py --host 0.0.0.0 --port 8443
+    python tools/tls_test_server.py --no-keep-alive   # force un handshake par heartbeat
+"""
+import argparse
+import ipaddress
+import json
+import os
+import ssl
+import subprocess
+from http.server import BaseHTTPRequestHandler, ThreadingHTTPServer
+
+CERT_DIR = os.path.join(os.path.dirname(os.path.abspath(__file__)), "tls_test")
+
+
+def run(*args):
+    subprocess.run(args, check=True, cwd=CERT_DIR, stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL)
+
+
+def is_ip_address(name):
+    try:
+        ipaddress.ip_address(name)
+        return True
+    except ValueError:
+        return False
+
+
+def ensure_certificates(common_name):
+    os.makedirs(CERT_DIR, exist_ok=True)
+    cn_path = os.path.join(CERT_DIR, "server.cn")
+    if os.path.exists(os.path.join(CERT_DIR, "server.crt")) and os.path.exists(cn_path):
+        with open(cn_path) as f:
+            if f.read().strip() == common_name:
+                return
+    if not os.path.exists(os.path.join(CERT_DIR, "ca.crt")):
+        run("openssl", "ecparam", "-name", "prime256v1", "-genkey", "-noout", "-out", "ca.key")
+        run("openssl", "req", "-x509", "-new", "-key", "ca.key", "-sha256", "-days", "3650",
+            "-subj", "/CN=ProutOMetre Test CA", "-out", "ca.crt")
+    run("openssl", "ecparam", "-name", "prime256v1", "-genkey", "-noout", "-out", "server.key")
+    run("openssl", "req", "-new", "-key", "server.key", "-subj", "/CN=%s" % common_name, "-out", "server.csr")
+    with open(os.path.join(CERT_DIR, "san.ext"), "w") as f:
+        # SAN DNS toujours présent : c'est le seul que mbedTLS 2.x compare (même pour une IP)
+        san = "DNS:%s" % common_name
+        if is_ip_address(common_name):
+            san += ",IP:%s" % common_name
+        f.write("subjectAltName=%s\n" % san)
+    run("openssl", "x509", "-req", "-in", "server.csr", "-CA", "ca.crt", "-CAkey", "ca.key", "-CAcreateserial",
+        "-days", "3650", "-sha256", "-extfile", "san.ext", "-out", "server.crt")
+    with open(cn_path, "w") as f:
+        f.write(common_name + "\n")
+
+
+class Handler(BaseHTTPRequestHandler):
+    protocol_version = "HTTP/1.1"
+    keep_alive = True
+
+    def do_POST(self):
+        length = int(self.headers.get("Content-Length", 0))
+        payload = self.rfile.read(length)
+        try:
+            uuid = json.loads(payload).get("uuid", "?")
+        except ValueError:
+            uuid = "?"
+        body = json.dumps({"debug": False}).encode()
+        self.send_response(200)
+        self.send_header("Content-Type", "application/json")
+        self.send_header("Content-Length", str(len(body)))
+        if not self.keep_alive:
+            self.send_header("Connection", "close")
+            self.close_connection = True
+        self.end_headers()
+        self.wfile.write(body)
+        print("[INFO] %s : %d octets, session reprise=%s" % (uuid, length, self.connection.session_reused),
+              flush=True)
+
+    def log_message(self, format, *args):
+        pass
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Serveur HTTPS de test pour les handshakes TLS du device")
+    parser.add_argument("--host", default="0.0.0.0")
+    parser.add_argument("--port", type=int, default=8443)
+    parser.add_argument("--cn", default="192.168.0.18", help="IP ou nom du serveur tel que vu par le device")
+    parser.add_argument("--no-keep-alive", action="store_true")
+    args = parser.parse_args()
+
+    ensure_certificates(args.cn)
+    with open(os.path.join(CERT_DIR, "ca.crt")) as f:
+        print("[INFO] CA à copier dans TLS_ROOT_CA :\n" + f.read())
+
+    context = ssl.SSLContext(ssl.PROTOCOL_TLS_SERVER)
+    context.minimum_version = ssl.TLSVersion.TLSv1_2
+    context.maximum_version = ssl.TLSVersion.TLSv1_2
+    context.set_ciphers("ECDHE-ECDSA-AES128-GCM-SHA256:ECDHE-ECDSA-AES128-SHA256")
+    context.load_cert_chain(os.path.join(CERT_DIR, "server.crt"), os.path.join(CERT_DIR, "server.key"))
+
+    Handler.keep_alive = not args.no_keep_alive
+    server = ThreadingHTTPServer((args.host, args.port), Handler)
+    server.socket = context.wrap_socket(server.socket, server_side=True)
+    print(f"[INFO] Écoute sur https://{args.host}:{args.port}", flush=True)
+    server.serve_forever()
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,76 @@
+"""
+Conversion des traces du firmware au format Chrome trace_event
+(à ouvrir dans chrome://tracing ou https://ui.perfetto.dev).
+
+Sources acceptées :
+  - capture du port série contenant un dump (touche 't' envoyée au device), émis via les
+    logs : lignes "I <s.ms> TRACE nom,core,tâche,début_us,durée_us" (début sur 64 bits, sans
+    rebouclage), le préfixe de log étant facultatif (logs binaires : sortie de
+    tools/log_decoder.py) ;
+  - payload JSON d'un heartbeat contenant un tableau "trace".
+
+Usage :
+    python tools/trace_to_chrome.py capture_serie.txt -o trace.json
+    python tools/trace_to_chrome.py heartbeat.json -o trace.json
+"""
+import argparse
+import json
+import re
+
+# Préfixe de log facultatif ("I 12.345 "), puis la ligne de trace
+TRACE_LINE_RE = re.compile(r"^(?:[DIWE] \d+\.\d{3} )?TRACE (.*)$")
+
+
+def events_from_serial(text):
+    for line in text.splitlines():
+        match = TRACE_LINE_RE.match(line.strip())
+        if not match:
+            continue
+        fields = match.group(1).rsplit(",", 4)
+        if len(fields) != 5:
+            continue
+        name, core, task, start, duration = fields
+        yield {"name": name, "core": int(core), "task": task, "ts": int(start), "dur": int(duration)}
+
+
+def events_from_json(text):
+    payload = json.loads(text)
+    return payload.get("trace", [])
+
+
+def to_chrome(events):
+    trace_events = []
+    cores = set()
+    for event in events:
+        # Un processus par core, un thread par tâche FreeRTOS
+        trace_events.append({
+            "name": event["name"],
+            "ph": "X",
+            "ts": event["ts"],
+            "dur": event["dur"],
+            "pid": event["core"],
+            "tid": event["task"],
+        })
+        cores.add(event["core"])
+    for core in sorted(cores):
+        trace_events.append({"name": "process_name", "ph": "M", "pid": core, "args": {"name": "core %d" % core}})
+    return {"traceEvents": trace_events, "displayTimeUnit": "ms"}
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Conversion des traces ProutOMetre vers Chrome trace_event")
+    parser.add_argument("source", help="capture série ou payload JSON du heartbeat")
+    parser.add_argument("-o", "--output", default="trace.json")
+    args = parser.parse_args()
+
+    with open(args.source, encoding="utf-8", errors="replace") as f:
+        text = f.read()
+
+    events = events_from_json(text) if text.lstrip().startswith("{") else list(events_from_serial(text))
+    with open(args.output, "w") as f:
+        json.dump(to_chrome(events), f)
+    print(f"[INFO] {len(events)} événements écrits dans {args.output}")
+
+
+if __name__ == "__main__":
+    main()